@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <poll.h>
+#include <cerrno>
 #include <csignal>
 #include <filesystem>
 #include <fstream>
@@ -23,9 +25,13 @@
 #include <cxxopts.hpp>
 
 #include "drmpp/input/seat.h"
+#include "drmpp/kms/cursor_plane.h"
+#include "drmpp/kms/device.h"
 #include "drmpp/shared_libs/libdrm.h"
 
-struct Configuration {};
+struct Configuration {
+  bool latency;
+};
 
 static volatile bool gRunning = true;
 
@@ -34,14 +40,60 @@ class App final : public Logging,
                   public drmpp::input::PointerObserver,
                   public drmpp::input::SeatObserver {
  public:
-  explicit App(const Configuration& /*config */) {
+  explicit App(const Configuration& config) {
+    device_ = KmsDevice::AutoDetect();
+    if (device_ && !device_->GetOutputs().empty()) {
+      const auto& output = device_->GetOutputs().front();
+      // KmsDevice enables atomic
+      cursor_plane_ =
+          CursorPlane::Create(device_->GetDrmFd(), output->GetCrtcId(), true);
+      if (cursor_plane_ && config.latency) {
+        if (cursor_plane_->IsAtomic()) {
+          latency_output_ = output.get();
+          cursor_plane_->SetLatencyOutput(latency_output_);
+        } else {
+          LOG_WARN("Legacy cursor, latency is not measured");
+        }
+      }
+    } else {
+      LOG_ERROR("No connected output, hardware cursor disabled");
+    }
     seat_ = std::make_unique<drmpp::input::Seat>(false, "");
     seat_->register_observer(this, this);
   }
 
-  ~App() override { seat_.reset(); }
+  ~App() override {
+    seat_.reset();
+    cursor_plane_.reset();
+    if (latency_output_) {
+      latency_output_->LogLatency();
+    }
+  }
 
-  [[nodiscard]] bool run() const { return seat_->run_once(); }
+  [[nodiscard]] bool run() const {
+    if (!cursor_plane_ || !cursor_plane_->IsAtomic()) {
+      return seat_->wait_and_dispatch() >= 0;
+    }
+    // events libinput already queued do not make its fd readable
+    if (seat_->wait_and_dispatch(0) < 0) {
+      return false;
+    }
+    // cursor commits complete with a flip event on the DRM fd
+    pollfd fds[2] = {
+        {.fd = seat_->get_epoll_fd(), .events = POLLIN, .revents = 0},
+        {.fd = device_->GetDrmFd(), .events = POLLIN, .revents = 0},
+    };
+    if (poll(fds, 2, -1) < 0) {
+      return errno == EINTR;
+    }
+    if (fds[1].revents & POLLIN) {
+      drmEventContext ctx{};
+      ctx.version = 2;
+      ctx.page_flip_handler = handle_page_flip;
+      drm->HandleEvent(device_->GetDrmFd(), &ctx);
+    }
+    return true;
+  }
 
   void notify_seat_capabilities(drmpp::input::Seat* seat,
                                 uint32_t caps) override {
@@ -49,6 +101,12 @@ class App final : public Logging,
     if (caps & SEAT_CAPABILITIES_POINTER) {
       if (const auto pointer = seat_->get_pointer(); pointer.has_value()) {
         pointer.value()->register_observer(this, this);
+        if (device_ && !device_->GetOutputs().empty()) {
+          const auto& output = device_->GetOutputs().front();
+          pointer.value()->set_output_size(output->GetWidth(),
+                                           output->GetHeight());
+        }
+        pointer.value()->set_cursor(0, "left_ptr");
       }
     }
     if (caps & SEAT_CAPABILITIES_KEYBOARD) {
@@ -68,7 +126,8 @@ class App final : public Logging,
       bool keymap_key_repeats,
       const uint32_t state,
       int xdg_key_symbol_count,
-      const xkb_keysym_t* xdg_key_symbols) override {
+      const xkb_keysym_t* xdg_key_symbols,
+      uint32_t utf32) override {
     if (state == LIBINPUT_KEY_STATE_PRESSED) {
       if (xdg_key_symbols[0] == XKB_KEY_Escape ||
           xdg_key_symbols[0] == XKB_KEY_q || xdg_key_symbols[0] == XKB_KEY_Q) {
@@ -94,6 +153,20 @@ class App final : public Logging,
                              double sx,
                              double sy) override {
     LOG_TRACE("x: {}, y: {}", sx, sy);
+    if (cursor_plane_) {
+      // sx, sy are relative for mice, the pointer tracks the position
+      const auto [x, y] = pointer->get_xy();
+      cursor_plane_->Move(static_cast<int32_t>(x), static_cast<int32_t>(y),
+                          seat_->get_input_token().time_usec);
+    }
+  }
+
+  void notify_pointer_cursor(
+      drmpp::input::Pointer* pointer,
+      const std::shared_ptr<drmpp::XCursor::Images>& images) override {
+    if (cursor_plane_) {
+      cursor_plane_->SetCursor(images);
+    }
   }
 
   void notify_pointer_button(drmpp::input::Pointer* pointer,
@@ -133,6 +206,18 @@ class App final : public Logging,
   }
 
  private:
+  static void handle_page_flip(int /* fd */,
+                               unsigned int /* sequence */,
+                               const unsigned int tv_sec,
+                               const unsigned int tv_usec,
+                               void* user_data) {
+    // only the cursor plane commits here
+    static_cast<CursorPlane*>(user_data)->OnCursorFlip(tv_sec, tv_usec);
+  }
+
+  std::shared_ptr<KmsDevice> device_;
+  std::unique_ptr<CursorPlane> cursor_plane_;
+  Output* latency_output_{};
   std::unique_ptr<drmpp::input::Seat> seat_;
   std::mutex cmd_mutex_{};
 };
@@ -144,18 +229,21 @@ int main(const int argc, char** argv) {
     }
   });
 
+  Configuration config{};
   cxxopts::Options options("drm-cursor", "Render Cursor");
   options.set_width(80)
       .set_tab_expansion()
       .allow_unrecognised_options()
-      .add_options()("help", "Print help");
+      .add_options()("help", "Print help")(
+          "latency", "Log the input-to-scanout latency of cursor moves on exit",
+          cxxopts::value<bool>(config.latency));
 
   if (options.parse(argc, argv).count("help")) {
     spdlog::info("{}", options.help({"", "Group"}));
     exit(EXIT_SUCCESS);
   }
 
-  const App app({});
+  const App app(config);
 
   while (gRunning && app.run()) {
   }
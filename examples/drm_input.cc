@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <chrono>
 #include <csignal>
 #include <filesystem>
 #include <fstream>
@@ -28,13 +29,18 @@ extern "C" {
 #include <cxxopts.hpp>
 
 #include "drmpp/info/info.h"
+#include "drmpp/input/event_replayer.h"
 #include "drmpp/input/keyboard.h"
 #include "drmpp/input/seat.h"
 #include "drmpp/shared_libs/libdrm.h"
 #include "drmpp/utils/utils.h"
 #include "drmpp/utils/virtual_terminal.h"
 
-struct Configuration {};
+struct Configuration {
+  std::string record;
+  std::string replay;
+  bool fast;
+};
 
 static volatile bool gRunning = true;
 
@@ -42,14 +48,37 @@ class App final : public Logging,
                   public drmpp::input::KeyboardObserver,
                   public drmpp::input::SeatObserver {
  public:
-  explicit App(const Configuration& /*config */) {
-    seat_ = std::make_unique<drmpp::input::Seat>(false, "");
+  explicit App(const Configuration& config) {
+    if (config.replay.empty()) {
+      seat_ = std::make_unique<drmpp::input::Seat>(false, "");
+    } else {
+      // a path seat without devices, only the trace produces events
+      seat_ = std::make_unique<drmpp::input::Seat>(nullptr, "replay");
+    }
     seat_->register_observer(this, this);
+    if (!config.record.empty() && seat_->start_recording(config.record)) {
+      LOG_INFO("Recording input to {}", config.record);
+    }
   }
 
   ~App() override { seat_.reset(); }
 
-  [[nodiscard]] bool run() const { return seat_->run_once(); }
+  [[nodiscard]] bool run() const { return seat_->wait_and_dispatch() >= 0; }
+
+  [[nodiscard]] bool replay(const std::string& path, const bool fast) const {
+    drmpp::input::EventReplayer replayer;
+    if (!replayer.open(path)) {
+      return false;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const auto count = replayer.replay(*seat_, !fast);
+    const auto elapsed = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - start);
+    LOG_INFO("Replayed {} events in {:.0f} us ({:.3f} us/event)", count,
+             elapsed.count(),
+             count ? elapsed.count() / static_cast<double>(count) : 0.0);
+    return true;
+  }
 
   static void print_di_info(const di_info* info) {
     auto str = di_info_get_make(info);
@@ -174,7 +203,8 @@ class App final : public Logging,
       bool keymap_key_repeats,
       const uint32_t state,
       int xdg_key_symbol_count,
-      const xkb_keysym_t* xdg_key_symbols) override {
+      const xkb_keysym_t* xdg_key_symbols,
+      uint32_t utf32) override {
     if (state == LIBINPUT_KEY_STATE_PRESSED) {
       if (xdg_key_symbols[0] == XKB_KEY_Escape ||
           xdg_key_symbols[0] == XKB_KEY_q || xdg_key_symbols[0] == XKB_KEY_Q) {
@@ -294,10 +324,10 @@ class App final : public Logging,
     }
     LOG_INFO(
         "Key: time: {}, xkb_scancode: 0x{:X}, key_repeats: {}, state: {}, "
-        "xdg_keysym_count: {}, syms_out[0]: 0x{:X}",
+        "xdg_keysym_count: {}, syms_out[0]: 0x{:X}, utf32: U+{:04X}",
         time, xkb_scancode, keymap_key_repeats,
         state == LIBINPUT_KEY_STATE_PRESSED ? "press" : "release",
-        xdg_key_symbol_count, xdg_key_symbols[0]);
+        xdg_key_symbol_count, xdg_key_symbols[0], utf32);
   }
 
  private:
@@ -312,18 +342,31 @@ int main(const int argc, char** argv) {
     }
   });
 
+  Configuration config{};
   cxxopts::Options options("drm-input", "Input information");
   options.set_width(80)
       .set_tab_expansion()
       .allow_unrecognised_options()
-      .add_options()("help", "Print help");
-
-  if (options.parse(argc, argv).count("help")) {
+      .add_options()("help", "Print help")(
+          "record", "Record dispatched input events to a trace file",
+          cxxopts::value<std::string>(config.record))(
+          "replay", "Replay a trace file and exit",
+          cxxopts::value<std::string>(config.replay))(
+          "fast", "Replay as fast as possible instead of in real time",
+          cxxopts::value<bool>(config.fast));
+  const auto result = options.parse(argc, argv);
+
+  if (result.count("help")) {
     LOG_INFO("{}", options.help({"", "Group"}));
     exit(EXIT_SUCCESS);
   }
 
-  const App app({});
+  const App app(config);
+
+  if (!config.replay.empty()) {
+    return app.replay(config.replay, config.fast) ? EXIT_SUCCESS
+                                                  : EXIT_FAILURE;
+  }
 
   while (gRunning && app.run()) {
   }
@@ -14,7 +14,10 @@
  * limitations under the License.
  */
 
+#include <poll.h>
+#include <cerrno>
 #include <csignal>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <vector>
@@ -23,6 +26,7 @@
 #include <cxxopts.hpp>
 
 #include "drmpp/input/seat.h"
+#include "drmpp/kms/output.h"
 #include "drmpp/logging/logging.h"
 #include "drmpp/shared_libs/libdrm.h"
 #include "drmpp/shared_libs/libegl.h"
@@ -34,6 +38,7 @@
 struct Configuration {
   std::string device = "/dev/dri/card0";
   size_t mode_index = 0;
+  bool latency = false;
 };
 
 static volatile bool gRunning = true;
@@ -46,6 +51,7 @@ class DrmSnakeApp final : public Logging,
   explicit DrmSnakeApp(const Configuration& config) {
     device_ = config.device;
     mode_index_ = config.mode_index;
+    latency_ = config.latency;
 
     init_drm();
 
@@ -56,7 +62,12 @@ class DrmSnakeApp final : public Logging,
     seat_->run_once();
   }
 
-  ~DrmSnakeApp() override { cleanup_drm(); }
+  ~DrmSnakeApp() override {
+    if (latency_) {
+      output_->LogLatency();
+    }
+    cleanup_drm();
+  }
 
   bool run() {
     while (gRunning) {
@@ -86,6 +97,7 @@ class DrmSnakeApp final : public Logging,
 
     drm_.connector_id = connector->connector_id;
     drm_.mode_info = connector->modes[mode_index_];
+    const auto connector_type = connector->connector_type;
 
     const auto encoder = find_encoder(fd_, connector);
     assert(encoder != nullptr);
@@ -97,6 +109,15 @@ class DrmSnakeApp final : public Logging,
     drm->ModeFreeConnector(connector);
     drm->ModeFreeResources(resources);
 
+    // legacy page flips scan out on the primary plane, its id is not needed
+    const auto& mode = drm_.mode_info;
+    const uint64_t refresh =
+        ((mode.clock * 1000000LL / mode.htotal) + (mode.vtotal / 2)) /
+        mode.vtotal;
+    output_ = std::make_unique<Output>(0, drm_.crtc->crtc_id,
+                                       drm_.connector_id, connector_type, mode,
+                                       refresh, false, -1);
+
     gbm_.device = gbm->create_device(fd_);
     assert(gbm_.device != nullptr);
 
@@ -179,8 +200,12 @@ class DrmSnakeApp final : public Logging,
     const auto pitch = gbm->bo_get_stride(gbm_.bo);
     drm->ModeAddFB(fd_, drm_.mode_info.hdisplay, drm_.mode_info.vdisplay, 24,
                    32, pitch, handle, &drm_.fb);
-    drm->ModeSetCrtc(fd_, drm_.crtc->crtc_id, drm_.fb, 0, 0, &drm_.connector_id,
-                     1, &drm_.mode_info);
+    // the first frame sets the mode, later ones flip so the flip event tells
+    // when the frame, and the input it consumed, reached the screen
+    if (!gbm_.previous_bo || !page_flip()) {
+      drm->ModeSetCrtc(fd_, drm_.crtc->crtc_id, drm_.fb, 0, 0,
+                       &drm_.connector_id, 1, &drm_.mode_info);
+    }
     if (gbm_.previous_bo) {
       drm->ModeRmFB(fd_, drm_.previous_fb);
       gbm->surface_release_buffer(gbm_.surface, gbm_.previous_bo);
@@ -189,6 +214,46 @@ class DrmSnakeApp final : public Logging,
     drm_.previous_fb = drm_.fb;
   }
 
+  // Flips to drm_.fb and waits for the flip, so the previous buffer can be
+  // released. Returns false if the flip could not be queued.
+  bool page_flip() {
+    output_->SubmitFrame(seat_->get_input_token().time_usec);
+    if (drm->ModePageFlip(fd_, drm_.crtc->crtc_id, drm_.fb,
+                          DRM_MODE_PAGE_FLIP_EVENT, this) < 0) {
+      LOG_ERROR("drmModePageFlip: {}", std::strerror(errno));
+      output_->CancelFrame();
+      return false;
+    }
+
+    flip_pending_ = true;
+    drmEventContext ctx{};
+    ctx.version = 2;
+    ctx.page_flip_handler = handle_page_flip;
+    pollfd pfd{fd_, POLLIN, 0};
+    while (flip_pending_) {
+      const auto ret = poll(&pfd, 1, 1000);
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ret <= 0) {
+        LOG_ERROR("page flip timed out");
+        break;
+      }
+      drm->HandleEvent(fd_, &ctx);
+    }
+    return true;
+  }
+
+  static void handle_page_flip(int /* fd */,
+                               unsigned int /* sequence */,
+                               const unsigned int tv_sec,
+                               const unsigned int tv_usec,
+                               void* user_data) {
+    const auto app = static_cast<DrmSnakeApp*>(user_data);
+    app->output_->OnPageFlip(tv_sec, tv_usec);
+    app->flip_pending_ = false;
+  }
+
   void draw_snake() const {
     // Clear the screen
     glClear(GL_COLOR_BUFFER_BIT);
@@ -304,7 +369,8 @@ class DrmSnakeApp final : public Logging,
       bool keymap_key_repeats,
       const uint32_t state,
       int xdg_key_symbol_count,
-      const xkb_keysym_t* xdg_key_symbols) override {
+      const xkb_keysym_t* xdg_key_symbols,
+      uint32_t utf32) override {
     if (state == LIBINPUT_KEY_STATE_PRESSED) {
       if (xdg_key_symbols[0] == XKB_KEY_Escape ||
           xdg_key_symbols[0] == XKB_KEY_q || xdg_key_symbols[0] == XKB_KEY_Q) {
@@ -327,6 +393,9 @@ class DrmSnakeApp final : public Logging,
   }
 
   std::unique_ptr<drmpp::input::Seat> seat_;
+  std::unique_ptr<Output> output_;
+  bool flip_pending_{};
+  bool latency_{};
   SnakeContext snake_ctx_;
 
   std::string device_;
@@ -371,7 +440,9 @@ int main(const int argc, char** argv) {
       // clang-format off
       ("help", "Print help")
       ("d,device", "Path to device", cxxopts::value<std::string>(config.device))
-      ("m,mode", "Mode index", cxxopts::value<size_t>(config.mode_index));
+      ("m,mode", "Mode index", cxxopts::value<size_t>(config.mode_index))
+      ("latency", "Log the input-to-scanout latency of frames on exit",
+       cxxopts::value<bool>(config.latency));
   // clang-format on
 
   if (options.parse(argc, argv).count("help")) {
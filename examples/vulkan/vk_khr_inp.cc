@@ -538,7 +538,8 @@ class App final : public Logging,
       bool keymap_key_repeats,
       const uint32_t state,
       int xdg_key_symbol_count,
-      const xkb_keysym_t* xdg_key_symbols) override {
+      const xkb_keysym_t* xdg_key_symbols,
+      uint32_t utf32) override {
     if (state == LIBINPUT_KEY_STATE_PRESSED) {
       if (xdg_key_symbols[0] == XKB_KEY_Escape ||
           xdg_key_symbols[0] == XKB_KEY_q || xdg_key_symbols[0] == XKB_KEY_Q) {
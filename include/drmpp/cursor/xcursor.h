@@ -58,6 +58,7 @@ class XCursor {
   struct Images {
     std::vector<std::unique_ptr<Image>> images;  ///< Collection of images
     std::string name;  ///< Name associated with the images
+    uint32_t size{};   ///< Nominal size the images were made for
 
     /**
      * @brief Constructor for Images.
@@ -145,43 +146,13 @@ class XCursor {
   static void destroy_images(std::unique_ptr<Images>& images);
 
   /**
-   * @brief Reads a 32-bit unsigned integer from a file.
-   * @param file The input file stream.
-   * @param u The variable to store the read value.
-   * @return True if the read was successful, false otherwise.
-   */
-  static bool read_uint(std::ifstream& file, uint32_t& u);
-
-  /**
-   * @brief Reads the file header from a file.
-   * @param file The input file stream.
-   * @return A unique pointer to the read file header.
-   */
-  static std::unique_ptr<FileHeader> read_file_header(std::ifstream& file);
-
-  /**
-   * @brief Seeks to a table of contents entry in a file.
-   * @param file The input file stream.
-   * @param file_header The file header.
-   * @param toc The table of contents entry index.
-   * @return True if the seek was successful, false otherwise.
-   */
-  static bool seek_to_toc(std::ifstream& file,
-                          const FileHeader& file_header,
-                          int toc);
-
-  /**
-   * @brief Reads a chunk header from a file.
-   * @param file The input file stream.
-   * @param file_header The file header.
-   * @param toc The table of contents entry index.
-   * @param chunk_header The variable to store the read chunk header.
-   * @return True if the read was successful, false otherwise.
+   * @brief Parses the file header and table of contents from a buffer.
+   * @param data The cursor file contents.
+   * @param length The length of the contents in bytes.
+   * @return A unique pointer to the file header, or nullptr if it is invalid.
    */
-  static bool read_chunk_header(std::ifstream& file,
-                                const FileHeader& file_header,
-                                int toc,
-                                struct ChunkHeader& chunk_header);
+  static std::unique_ptr<FileHeader> read_file_header(const uint8_t* data,
+                                                      size_t length);
 
   /**
    * @brief Calculates the distance between two values.
@@ -214,83 +185,64 @@ class XCursor {
                             size_t count);
 
   /**
-   * @brief Reads an image from a file.
-   * @param file The input file stream.
+   * @brief Reads an image chunk from a buffer.
+   *
+   * The chunk is bounds checked once, then the pixels are copied in bulk.
+   *
+   * @param data The cursor file contents.
+   * @param length The length of the contents in bytes.
    * @param file_header The file header.
    * @param toc The table of contents entry index.
-   * @return A unique pointer to the read image.
+   * @return A unique pointer to the read image, or nullptr if it is invalid.
    */
-  static std::unique_ptr<Image> read_image(std::ifstream& file,
+  static std::unique_ptr<Image> read_image(const uint8_t* data,
+                                           size_t length,
                                            const FileHeader& file_header,
                                            int toc);
 
   /**
-   * @brief Loads images from a file.
-   * @param file The input file stream.
+   * @brief Loads the images closest to a size from a buffer.
+   * @param data The cursor file contents.
+   * @param length The length of the contents in bytes.
    * @param size The desired size.
    * @return A unique pointer to the loaded images.
    */
-  static std::unique_ptr<Images> load_images(std::ifstream& file,
-                                             int size = 24);
-
-  /**
-   * @brief Reads a 32-bit unsigned integer from a stream.
-   * @param file The input stream.
-   * @param u The variable to store the read value.
-   * @return True if the read was successful, false otherwise.
-   */
-  static bool read_uint(std::istream& file, uint32_t& u);
-
-  /**
-   * @brief Reads the file header from a stream.
-   * @param file The input stream.
-   * @return A unique pointer to the read file header.
-   */
-  static std::unique_ptr<FileHeader> read_file_header(std::istream& file);
-
-  /**
-   * @brief Seeks to a table of contents entry in a stream.
-   * @param file The input stream.
-   * @param file_header The file header.
-   * @param toc The table of contents entry index.
-   * @return True if the seek was successful, false otherwise.
-   */
-  static bool seek_to_toc(std::istream& file,
-                          const FileHeader& file_header,
-                          int toc);
+  static std::unique_ptr<Images> load_images(const uint8_t* data,
+                                             size_t length,
+                                             uint32_t size = 24);
 
   /**
-   * @brief Reads a chunk header from a stream.
-   * @param file The input stream.
-   * @param file_header The file header.
-   * @param toc The table of contents entry index.
-   * @param chunk_header The variable to store the read chunk header.
-   * @return True if the read was successful, false otherwise.
+   * @brief Loads images from a buffer.
+   * @param buffer The input buffer.
+   * @param size The desired size.
+   * @return A unique pointer to the loaded images.
    */
-  static bool read_chunk_header(std::istream& file,
-                                const FileHeader& file_header,
-                                int toc,
-                                ChunkHeader& chunk_header);
+  static std::unique_ptr<Images> load_images(const std::vector<uint8_t>& buffer,
+                                             uint32_t size = 24);
 
   /**
-   * @brief Reads an image from a stream.
-   * @param file The input stream.
-   * @param file_header The file header.
-   * @param toc The table of contents entry index.
-   * @return A unique pointer to the read image.
+   * @brief Loads images from a file stream.
+   *
+   * The remainder of the stream is read into memory and parsed from there.
+   *
+   * @param file The input file stream.
+   * @param size The desired size.
+   * @return A unique pointer to the loaded images.
    */
-  static std::unique_ptr<Image> read_image(std::istream& file,
-                                           const FileHeader& file_header,
-                                           int toc);
+  static std::unique_ptr<Images> load_images(std::ifstream& file,
+                                             int size = 24);
 
   /**
-   * @brief Loads images from a buffer.
-   * @param buffer The input buffer.
+   * @brief Loads images from a cursor file.
+   *
+   * The file is mapped read-only and parsed in place.
+   *
+   * @param path The path of the cursor file.
    * @param size The desired size.
-   * @return A unique pointer to the loaded images.
+   * @return A unique pointer to the loaded images, or nullptr on error.
    */
-  static std::unique_ptr<Images> load_images(const std::vector<uint8_t>& buffer,
-                                             uint32_t size = 24);
+  static std::unique_ptr<Images> load_file(const std::filesystem::path& path,
+                                           uint32_t size = 24);
 };
 }  // namespace drmpp
 #endif  // INCLUDE_CURSOR_XCURSOR_H
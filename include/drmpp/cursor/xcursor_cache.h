@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_CURSOR_XCURSOR_CACHE_H
+#define INCLUDE_CURSOR_XCURSOR_CACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "cursor/xcursor.h"
+
+namespace drmpp {
+/**
+ * @class XCursorCache
+ * @brief Cursor images prepared for an output scale.
+ *
+ * Each cursor is resolved once per (theme, name, size, scale). A file size
+ * matching the scaled size is used as is, otherwise the next larger size is
+ * box filtered down to it. XCursor pixels are premultiplied ARGB, and stay
+ * so through the filter. Entries are expired least recently used first.
+ */
+class XCursorCache {
+ public:
+  static constexpr size_t kDefaultCapacity = 64;  ///< Cached cursor sets
+
+  /**
+   * @brief Constructs an empty cache.
+   * @param capacity The number of cursor sets kept in memory.
+   */
+  explicit XCursorCache(size_t capacity = kDefaultCapacity);
+
+  /**
+   * @brief Gets the cache shared by the Pointer instances of the process.
+   * @return The shared cache.
+   */
+  static XCursorCache& get_shared();
+
+  /**
+   * @brief Gets the images of a cursor for an output scale.
+   * @param theme The name of the theme.
+   * @param name The name of the cursor.
+   * @param size The nominal size in logical pixels.
+   * @param scale The output scale.
+   * @return A shared pointer to the images, or nullptr if not found.
+   */
+  std::shared_ptr<XCursor::Images> get(const std::string& theme,
+                                       const std::string& name,
+                                       uint32_t size,
+                                       double scale = 1.0);
+
+  /**
+   * @brief Box filters images down to a nominal size.
+   *
+   * Images at or below the size are copied unchanged. Hotspots are scaled
+   * with the images.
+   *
+   * @param images The source images.
+   * @param size The nominal size to produce.
+   * @return A unique pointer to the scaled images.
+   */
+  static std::unique_ptr<XCursor::Images> downscale(
+      const XCursor::Images& images,
+      uint32_t size);
+
+  /**
+   * @brief Drops all entries.
+   */
+  void clear();
+
+  /**
+   * @brief Gets the number of cached cursor sets.
+   * @return The number of entries.
+   */
+  [[nodiscard]] size_t size() const;
+
+  // Disallow copy and assign.
+  XCursorCache(const XCursorCache&) = delete;
+
+  XCursorCache& operator=(const XCursorCache&) = delete;
+
+ private:
+  /**
+   * @struct CacheEntry
+   * @brief Cursor images prepared for a scale.
+   */
+  struct CacheEntry {
+    std::string key;                          ///< Cache key
+    std::shared_ptr<XCursor::Images> images;  ///< Prepared images
+  };
+
+  size_t capacity_;            ///< Maximum number of cache entries
+  std::list<CacheEntry> lru_;  ///< Cache entries, most recent first
+  std::unordered_map<std::string, std::list<CacheEntry>::iterator>
+      cache_;                  ///< Cache entries by key
+  mutable std::mutex mutex_;   ///< Guards the cache
+};
+}  // namespace drmpp
+#endif  // INCLUDE_CURSOR_XCURSOR_CACHE_H
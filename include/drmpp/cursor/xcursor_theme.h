@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_CURSOR_XCURSOR_THEME_H
+#define INCLUDE_CURSOR_XCURSOR_THEME_H
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cursor/xcursor.h"
+
+namespace drmpp {
+/**
+ * @class XCursorTheme
+ * @brief Index of the cursors of a theme and the themes it inherits.
+ *
+ * The search path is scanned once when the theme is created. Cursor files
+ * are only read on first use, and kept in an LRU cache keyed by file and
+ * size. Cursor names that are symlinks to the same file share cache entries.
+ */
+class XCursorTheme {
+ public:
+  static constexpr size_t kDefaultCapacity = 32;  ///< Cached cursor sets
+
+  /**
+   * @brief Constructs and indexes a theme.
+   * @param name The name of the theme.
+   * @param capacity The number of cursor sets kept in memory.
+   */
+  explicit XCursorTheme(std::string name, size_t capacity = kDefaultCapacity);
+
+  /**
+   * @brief Gets the shared index of a theme, creating it on first use.
+   * @param name The name of the theme.
+   * @return A shared pointer to the theme.
+   */
+  static std::shared_ptr<XCursorTheme> load(const std::string& name);
+
+  /**
+   * @brief Gets the directories searched for cursor themes.
+   *
+   * Honors XCURSOR_PATH, otherwise uses the libXcursor default search path.
+   * Resolved once per process.
+   *
+   * @return The search path in priority order.
+   */
+  static const std::vector<std::filesystem::path>& get_search_path();
+
+  /**
+   * @brief Gets the name of the theme.
+   * @return The name of the theme.
+   */
+  [[nodiscard]] const std::string& get_name() const { return name_; }
+
+  /**
+   * @brief Gets the theme and the themes it inherits, in lookup order.
+   * @return The theme names.
+   */
+  [[nodiscard]] const std::vector<std::string>& get_themes() const {
+    return themes_;
+  }
+
+  /**
+   * @brief Gets the cursor names provided by the theme or its parents.
+   * @return The sorted cursor names.
+   */
+  [[nodiscard]] std::vector<std::string> get_cursor_names() const;
+
+  /**
+   * @brief Checks if the theme provides a cursor.
+   * @param name The name of the cursor.
+   * @return True if the cursor exists, false otherwise.
+   */
+  [[nodiscard]] bool has_cursor(const std::string& name) const {
+    return index_.count(name) != 0;
+  }
+
+  /**
+   * @brief Gets the images of a cursor, loading the file if needed.
+   *
+   * Aliases of a cursor return the same images, named after the cursor file
+   * rather than the alias looked up.
+   * @param name The name of the cursor.
+   * @param size The desired nominal size.
+   * @return A shared pointer to the images, or nullptr if not found.
+   */
+  std::shared_ptr<XCursor::Images> get_cursor(const std::string& name,
+                                              uint32_t size);
+
+  // Disallow copy and assign.
+  XCursorTheme(const XCursorTheme&) = delete;
+
+  XCursorTheme& operator=(const XCursorTheme&) = delete;
+
+ private:
+  /**
+   * @struct CacheEntry
+   * @brief Cursor images loaded from a file at a size.
+   */
+  struct CacheEntry {
+    std::string key;                          ///< Cache key
+    std::shared_ptr<XCursor::Images> images;  ///< Loaded images
+  };
+
+  std::string name_;                 ///< Name of the theme
+  std::vector<std::string> themes_;  ///< Theme and inherited themes
+  std::unordered_map<std::string, std::filesystem::path>
+      index_;  ///< Resolved cursor file by name
+
+  size_t capacity_;                ///< Maximum number of cache entries
+  std::list<CacheEntry> lru_;      ///< Cache entries, most recent first
+  std::unordered_map<std::string, std::list<CacheEntry>::iterator>
+      cache_;                      ///< Cache entries by key
+  std::mutex mutex_;               ///< Guards the cache
+
+  /**
+   * @brief Adds the cursors of a theme and its parents to the index.
+   * @param theme The name of the theme.
+   */
+  void index_theme(const std::string& theme);
+};
+}  // namespace drmpp
+#endif  // INCLUDE_CURSOR_XCURSOR_THEME_H
@@ -31,10 +31,15 @@ extern "C" {
 }
 
 #include "cursor/xcursor.h"
+#include "cursor/xcursor_cache.h"
+#include "cursor/xcursor_theme.h"
 #include "info/info.h"
+#include "input/gesture.h"
 #include "input/keyboard.h"
 #include "input/pointer.h"
 #include "input/seat.h"
+#include "input/seat_manager.h"
+#include "input/tablet.h"
 #include "input/touch.h"
 #include "logging/logging.h"
 #include "plane/plane.h"
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_DRMPP_INPUT_EVENT_RECORDER_H_
+#define INCLUDE_DRMPP_INPUT_EVENT_RECORDER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace drmpp::input {
+/**
+ * \brief Decoded input event as dispatched by a Seat.
+ *
+ * This is the unit stored in an event trace. It carries everything the
+ * Keyboard, Pointer, Touch, Tablet and Gesture handlers consume, so a trace
+ * can be replayed without libinput.
+ */
+struct EventRecord {
+  uint64_t time_usec; /**< Event time in microseconds */
+  uint16_t type;      /**< libinput_event_type */
+  uint16_t device;    /**< Seat device id, or 0 if unknown */
+  uint16_t caps;      /**< SeatObserver capabilities of the device */
+  uint16_t reserved;  /**< Padding, always zero */
+  uint32_t code;      /**< Key, button, axis source, tool type or fingers */
+  uint32_t state;     /**< Key, button, tip, proximity or cancelled state */
+  int16_t slot;       /**< Touch slot, or -1 */
+  int16_t seat_slot;  /**< Touch seat slot, or -1 */
+  float pressure;     /**< Tablet tool pressure normalized to [0, 1] */
+  double x;           /**< Relative delta, or absolute x-coordinate in mm */
+  double y;           /**< Relative delta, or absolute y-coordinate in mm */
+  float nx;           /**< Normalized x-coordinate, or gesture scale */
+  float ny;           /**< Normalized y-coordinate, or gesture angle delta */
+  float tilt_x;       /**< Tablet tool tilt along the x axis in degrees */
+  float tilt_y;       /**< Tablet tool tilt along the y axis in degrees */
+};
+
+static_assert(std::is_trivially_copyable_v<EventRecord>);
+static_assert(sizeof(EventRecord) == 64);
+
+/**
+ * \brief Header at the start of an event trace file.
+ */
+struct EventTraceHeader {
+  static constexpr char kMagic[8] = {'D', 'R', 'M', 'P', 'P', 'E', 'V', 'T'};
+  static constexpr uint32_t kVersion = 1;
+
+  char magic[8];        /**< Always kMagic */
+  uint32_t version;     /**< Trace format version */
+  uint32_t record_size; /**< sizeof(EventRecord) */
+  uint64_t count;       /**< Number of records that follow */
+  uint64_t reserved;    /**< Padding, always zero */
+};
+
+static_assert(sizeof(EventTraceHeader) == 32);
+
+/**
+ * \brief Records dispatched input events into a memory-mapped trace file.
+ *
+ * Records are appended into a shared mapping of the file, which is grown in
+ * chunks, so recording does not issue a system call per event. close() trims
+ * the file to the records written.
+ */
+class EventRecorder {
+ public:
+  EventRecorder() = default;
+
+  /**
+   * \brief Destroys the EventRecorder instance, closing the trace.
+   */
+  ~EventRecorder();
+
+  /**
+   * \brief Creates or truncates a trace file and starts recording.
+   *
+   * \param path The path of the trace file.
+   * \return True on success, false otherwise.
+   */
+  bool open(const std::string& path);
+
+  /**
+   * \brief Finalizes the header and closes the trace file.
+   */
+  void close();
+
+  /**
+   * \brief Checks if a trace file is open.
+   *
+   * \return True if recording, false otherwise.
+   */
+  [[nodiscard]] bool is_open() const { return fd_ >= 0; }
+
+  /**
+   * \brief Appends a record to the trace.
+   *
+   * \param record The record to append.
+   * \return True on success, false if the trace could not be grown.
+   */
+  bool append(const EventRecord& record);
+
+  /**
+   * \brief Gets the number of records written so far.
+   *
+   * \return The number of records.
+   */
+  [[nodiscard]] uint64_t size() const { return count_; }
+
+  // Disallow copy and assign.
+  EventRecorder(const EventRecorder&) = delete;
+
+  EventRecorder& operator=(const EventRecorder&) = delete;
+
+ private:
+  static constexpr size_t kGrowRecords = 4096;
+
+  int fd_ = -1;         /**< Trace file descriptor */
+  void* map_{};         /**< Mapping of the trace file */
+  size_t map_size_{};   /**< Size of the mapping in bytes */
+  uint64_t count_{};    /**< Records written */
+  uint64_t capacity_{}; /**< Records that fit the mapping */
+
+  /**
+   * \brief Grows the trace file and its mapping.
+   *
+   * \return True on success, false otherwise.
+   */
+  bool grow();
+};
+}  // namespace drmpp::input
+
+#endif  // INCLUDE_DRMPP_INPUT_EVENT_RECORDER_H_
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_DRMPP_INPUT_EVENT_REPLAYER_H_
+#define INCLUDE_DRMPP_INPUT_EVENT_REPLAYER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "input/event_recorder.h"
+
+namespace drmpp::input {
+class Seat;
+
+/**
+ * \brief Replays a trace written by EventRecorder through a Seat.
+ *
+ * The trace is memory-mapped read-only and each record is handed to
+ * Seat::handle_record(), which routes it through the same Keyboard, Pointer
+ * and Touch handlers as live events. Device added records create the
+ * handlers, so no input hardware is needed.
+ */
+class EventReplayer {
+ public:
+  EventReplayer() = default;
+
+  /**
+   * \brief Destroys the EventReplayer instance, closing the trace.
+   */
+  ~EventReplayer();
+
+  /**
+   * \brief Opens and validates a trace file.
+   *
+   * \param path The path of the trace file.
+   * \return True on success, false otherwise.
+   */
+  bool open(const std::string& path);
+
+  /**
+   * \brief Closes the trace file.
+   */
+  void close();
+
+  /**
+   * \brief Gets the records of the trace.
+   *
+   * \return Pointer to the first record, or nullptr if no trace is open.
+   */
+  [[nodiscard]] const EventRecord* records() const { return records_; }
+
+  /**
+   * \brief Gets the number of records in the trace.
+   *
+   * \return The number of records.
+   */
+  [[nodiscard]] uint64_t size() const { return count_; }
+
+  /**
+   * \brief Replays the trace through a seat.
+   *
+   * \param seat The seat to dispatch the records to.
+   * \param realtime Whether to preserve the original event timing. When false
+   * the records are dispatched as fast as possible.
+   * \return The number of records dispatched.
+   */
+  uint64_t replay(Seat& seat, bool realtime) const;
+
+  // Disallow copy and assign.
+  EventReplayer(const EventReplayer&) = delete;
+
+  EventReplayer& operator=(const EventReplayer&) = delete;
+
+ private:
+  void* map_{};                  /**< Mapping of the trace file */
+  size_t map_size_{};            /**< Size of the mapping in bytes */
+  const EventRecord* records_{}; /**< First record of the trace */
+  uint64_t count_{};             /**< Number of records */
+};
+}  // namespace drmpp::input
+
+#endif  // INCLUDE_DRMPP_INPUT_EVENT_REPLAYER_H_
@@ -0,0 +1,336 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_DRMPP_INPUT_GESTURE_H_
+#define INCLUDE_DRMPP_INPUT_GESTURE_H_
+
+#include <cstdint>
+
+#include "utils/observer_list.h"
+
+namespace drmpp::input {
+class Gesture;
+
+/**
+ * \brief Interface for observing touchpad gesture events.
+ *
+ * All notifications have empty defaults, observers override the gestures
+ * they use.
+ */
+class GestureObserver {
+ public:
+  /**
+   * \brief Virtual destructor for the GestureObserver class.
+   */
+  virtual ~GestureObserver() = default;
+
+  /**
+   * \brief Notify the observer of the start of a swipe.
+   *
+   * \param gesture Pointer to the Gesture object.
+   * \param time Event time.
+   * \param fingers The number of fingers.
+   */
+  virtual void notify_gesture_swipe_begin(Gesture* /* gesture */,
+                                          uint32_t /* time */,
+                                          uint32_t /* fingers */) {}
+
+  /**
+   * \brief Notify the observer of swipe motion.
+   *
+   * \param gesture Pointer to the Gesture object.
+   * \param time Event time.
+   * \param fingers The number of fingers.
+   * \param dx The motion of the center along the x axis.
+   * \param dy The motion of the center along the y axis.
+   */
+  virtual void notify_gesture_swipe_update(Gesture* /* gesture */,
+                                           uint32_t /* time */,
+                                           uint32_t /* fingers */,
+                                           double /* dx */,
+                                           double /* dy */) {}
+
+  /**
+   * \brief Notify the observer of the end of a swipe.
+   *
+   * \param gesture Pointer to the Gesture object.
+   * \param time Event time.
+   * \param fingers The number of fingers.
+   * \param cancelled Whether the swipe was cancelled.
+   */
+  virtual void notify_gesture_swipe_end(Gesture* /* gesture */,
+                                        uint32_t /* time */,
+                                        uint32_t /* fingers */,
+                                        bool /* cancelled */) {}
+
+  /**
+   * \brief Notify the observer of the start of a pinch.
+   *
+   * \param gesture Pointer to the Gesture object.
+   * \param time Event time.
+   * \param fingers The number of fingers.
+   */
+  virtual void notify_gesture_pinch_begin(Gesture* /* gesture */,
+                                          uint32_t /* time */,
+                                          uint32_t /* fingers */) {}
+
+  /**
+   * \brief Notify the observer of pinch motion.
+   *
+   * \param gesture Pointer to the Gesture object.
+   * \param time Event time.
+   * \param fingers The number of fingers.
+   * \param dx The motion of the center along the x axis.
+   * \param dy The motion of the center along the y axis.
+   * \param scale The scale relative to the start of the pinch.
+   * \param angle_delta The rotation since the last update in degrees.
+   */
+  virtual void notify_gesture_pinch_update(Gesture* /* gesture */,
+                                           uint32_t /* time */,
+                                           uint32_t /* fingers */,
+                                           double /* dx */,
+                                           double /* dy */,
+                                           double /* scale */,
+                                           double /* angle_delta */) {}
+
+  /**
+   * \brief Notify the observer of the end of a pinch.
+   *
+   * \param gesture Pointer to the Gesture object.
+   * \param time Event time.
+   * \param fingers The number of fingers.
+   * \param cancelled Whether the pinch was cancelled.
+   */
+  virtual void notify_gesture_pinch_end(Gesture* /* gesture */,
+                                        uint32_t /* time */,
+                                        uint32_t /* fingers */,
+                                        bool /* cancelled */) {}
+
+  /**
+   * \brief Notify the observer of the start of a hold.
+   *
+   * \param gesture Pointer to the Gesture object.
+   * \param time Event time.
+   * \param fingers The number of fingers.
+   */
+  virtual void notify_gesture_hold_begin(Gesture* /* gesture */,
+                                         uint32_t /* time */,
+                                         uint32_t /* fingers */) {}
+
+  /**
+   * \brief Notify the observer of the end of a hold.
+   *
+   * \param gesture Pointer to the Gesture object.
+   * \param time Event time.
+   * \param fingers The number of fingers.
+   * \param cancelled Whether the hold was cancelled.
+   */
+  virtual void notify_gesture_hold_end(Gesture* /* gesture */,
+                                       uint32_t /* time */,
+                                       uint32_t /* fingers */,
+                                       bool /* cancelled */) {}
+};
+
+/**
+ * \brief Class representing the touchpad gestures of a seat.
+ */
+class Gesture {
+ public:
+  /**
+   * \brief Struct representing the event mask.
+   */
+  struct event_mask {
+    bool enabled; /**< Whether the event mask is enabled */
+    bool all;     /**< Whether all events are masked */
+  };
+
+  /**
+   * \brief Constructs a Gesture instance.
+   *
+   * \param event_mask The initial event mask.
+   */
+  explicit Gesture(event_mask const& event_mask);
+
+  /**
+   * \brief Registers an observer for gesture events.
+   *
+   * \param observer The observer to be registered.
+   * \param user_data User data to be passed to the observer.
+   */
+  void register_observer(GestureObserver* observer, void* user_data = nullptr) {
+    observers_.add(observer);
+
+    if (user_data) {
+      user_data_ = user_data;
+    }
+  }
+
+  /**
+   * \brief Unregisters an observer for gesture events.
+   *
+   * \param observer The observer to be unregistered.
+   */
+  void unregister_observer(GestureObserver* observer) {
+    observers_.remove(observer);
+  }
+
+  /**
+   * \brief Gets the user data.
+   *
+   * \return Pointer to the user data.
+   */
+  [[nodiscard]] void* get_user_data() const { return user_data_; }
+
+  /**
+   * \brief Sets the event mask.
+   *
+   * \param event_mask The event mask to be set.
+   */
+  void set_event_mask(event_mask const& event_mask);
+
+  /**
+   * \brief Enables or disables per-frame coalescing of gesture updates.
+   *
+   * While enabled, swipe and pinch updates are merged until flush_motion()
+   * delivers them: motion and rotation are summed, the latest scale is kept.
+   *
+   * \param enable Whether to coalesce gesture updates.
+   */
+  void set_motion_coalescing(bool enable);
+
+  /**
+   * \brief Delivers the coalesced gesture update.
+   *
+   * Call once per frame when coalescing is enabled. A pending update is also
+   * flushed before the gesture ends.
+   */
+  void flush_motion();
+
+  /**
+   * \brief Handles a decoded swipe begin event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param fingers The number of fingers.
+   */
+  void handle_swipe_begin(uint32_t time, uint32_t fingers);
+
+  /**
+   * \brief Handles a decoded swipe update event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param fingers The number of fingers.
+   * \param dx The motion along the x axis.
+   * \param dy The motion along the y axis.
+   */
+  void handle_swipe_update(uint32_t time,
+                           uint32_t fingers,
+                           double dx,
+                           double dy);
+
+  /**
+   * \brief Handles a decoded swipe end event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param fingers The number of fingers.
+   * \param cancelled Whether the swipe was cancelled.
+   */
+  void handle_swipe_end(uint32_t time, uint32_t fingers, bool cancelled);
+
+  /**
+   * \brief Handles a decoded pinch begin event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param fingers The number of fingers.
+   */
+  void handle_pinch_begin(uint32_t time, uint32_t fingers);
+
+  /**
+   * \brief Handles a decoded pinch update event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param fingers The number of fingers.
+   * \param dx The motion along the x axis.
+   * \param dy The motion along the y axis.
+   * \param scale The absolute scale.
+   * \param angle_delta The rotation in degrees.
+   */
+  void handle_pinch_update(uint32_t time,
+                           uint32_t fingers,
+                           double dx,
+                           double dy,
+                           double scale,
+                           double angle_delta);
+
+  /**
+   * \brief Handles a decoded pinch end event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param fingers The number of fingers.
+   * \param cancelled Whether the pinch was cancelled.
+   */
+  void handle_pinch_end(uint32_t time, uint32_t fingers, bool cancelled);
+
+  /**
+   * \brief Handles a decoded hold begin event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param fingers The number of fingers.
+   */
+  void handle_hold_begin(uint32_t time, uint32_t fingers);
+
+  /**
+   * \brief Handles a decoded hold end event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param fingers The number of fingers.
+   * \param cancelled Whether the hold was cancelled.
+   */
+  void handle_hold_end(uint32_t time, uint32_t fingers, bool cancelled);
+
+  // Disallow copy and assign.
+  Gesture(const Gesture&) = delete;
+
+  Gesture& operator=(const Gesture&) = delete;
+
+ private:
+  utils::ObserverList<GestureObserver> observers_{}; /**< Observers */
+  void* user_data_{};                                /**< User data */
+  event_mask event_mask_{};                          /**< Event mask */
+  bool coalesce_{}; /**< Whether updates are coalesced */
+
+  struct {
+    bool pending;       /**< Whether an update awaits delivery */
+    bool pinch;         /**< Whether the update is a pinch */
+    uint32_t time;      /**< Time of the last merged update */
+    uint32_t fingers;   /**< Number of fingers */
+    double dx;          /**< Summed motion along the x axis */
+    double dy;          /**< Summed motion along the y axis */
+    double scale;       /**< Latest scale */
+    double angle_delta; /**< Summed rotation */
+  } update_{};          /**< Coalesced update */
+
+  /**
+   * \brief Checks if all gesture events are masked.
+   *
+   * \return True if masked, false otherwise.
+   */
+  [[nodiscard]] bool is_masked() const {
+    return event_mask_.enabled && event_mask_.all;
+  }
+};
+}  // namespace drmpp::input
+
+#endif  // INCLUDE_DRMPP_INPUT_GESTURE_H_
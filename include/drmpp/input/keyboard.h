@@ -17,14 +17,18 @@
 #ifndef INCLUDE_DRMPP_INPUT_KEYBOARD_H_
 #define INCLUDE_DRMPP_INPUT_KEYBOARD_H_
 
-#include <list>
-#include <mutex>
+#include <array>
+#include <bitset>
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <libinput.h>
 #include <xkbcommon/xkbcommon.h>
-#include <csignal>
+
+#include "input/keymap_cache.h"
+#include "utils/observer_list.h"
 
 namespace drmpp::input {
 class Keyboard;
@@ -54,6 +58,8 @@ class KeyboardObserver {
    * \param state The state of the key (pressed or released).
    * \param xdg_key_symbol_count The number of key symbols.
    * \param xdg_key_symbols Pointer to the key symbols.
+   * \param utf32 The UTF-32 character the key produces, or 0 if it produces
+   * none or is released.
    */
   virtual void notify_keyboard_xkb_v1_key(
       Keyboard* keyboard,
@@ -62,7 +68,8 @@ class KeyboardObserver {
       bool keymap_key_repeats,
       uint32_t state,
       int xdg_key_symbol_count,
-      const xkb_keysym_t* xdg_key_symbols) = 0;
+      const xkb_keysym_t* xdg_key_symbols,
+      uint32_t utf32) = 0;
 };
 
 /**
@@ -78,10 +85,36 @@ class Keyboard {
     bool all;     /**< Whether all events are masked */
   };
 
+  /**
+   * \brief Enum representing the modifiers known to is_modifier_active().
+   */
+  enum Modifier {
+    MODIFIER_SHIFT, /**< Shift */
+    MODIFIER_CAPS,  /**< Caps Lock */
+    MODIFIER_CTRL,  /**< Control */
+    MODIFIER_ALT,   /**< Alt (Mod1) */
+    MODIFIER_NUM,   /**< Num Lock (Mod2) */
+    MODIFIER_LOGO,  /**< Logo (Mod4) */
+    MODIFIER_COUNT, /**< Number of modifiers */
+  };
+
+  /**
+   * \brief Struct representing the serialized modifier and layout state.
+   */
+  struct modifier_state {
+    xkb_mod_mask_t depressed;  /**< Modifiers held down */
+    xkb_mod_mask_t latched;    /**< Modifiers latched */
+    xkb_mod_mask_t locked;     /**< Modifiers locked */
+    xkb_layout_index_t layout; /**< Effective layout */
+  };
+
+  static constexpr uint32_t kMaxKeys = 768; /**< evdev KEY_MAX + 1 */
+
   /**
    * \brief Constructs a Keyboard instance.
    *
    * \param event_mask The event mask to be used.
+   * \param keymap_cache Shared keymap cache, or nullptr to create one.
    * \param model The XKB model.
    * \param layout The XKB layout.
    * \param variant The XKB variant.
@@ -90,6 +123,7 @@ class Keyboard {
    * \param repeat The repeat rate for key repeat (default is 33).
    */
   explicit Keyboard(event_mask const& event_mask,
+                    std::shared_ptr<KeymapCache> keymap_cache,
                     const char* model,
                     const char* layout,
                     const char* variant,
@@ -138,6 +172,15 @@ class Keyboard {
    */
   void handle_keyboard_event(libinput_event_keyboard* key_event);
 
+  /**
+   * \brief Handles a decoded key event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param key The evdev key code.
+   * \param state The state of the key.
+   */
+  void handle_key(uint32_t time, uint32_t key, libinput_key_state state);
+
   /**
    * \brief Sets the event mask.
    *
@@ -145,43 +188,151 @@ class Keyboard {
    */
   void set_event_mask(event_mask const& event_mask);
 
+  /**
+   * \brief Gets the key repeat timer file descriptor.
+   *
+   * The descriptor is a CLOCK_MONOTONIC timerfd that becomes readable when a
+   * repeat is due. Call handle_repeat() when it is readable.
+   *
+   * \return The timer file descriptor.
+   */
+  [[nodiscard]] int get_repeat_fd() const { return repeat_.fd; }
+
+  /**
+   * \brief Delivers due key repeats to the observers.
+   *
+   * Each timer expiration is delivered as a key press event with a timestamp
+   * derived from the original press, the repeat delay and the repeat rate.
+   */
+  void handle_repeat();
+
+  /**
+   * \brief Checks if a key is held down.
+   *
+   * \param key The evdev key code.
+   * \return True if pressed, false otherwise.
+   */
+  [[nodiscard]] bool is_key_pressed(const uint32_t key) const {
+    return key < kMaxKeys && pressed_keys_.test(key);
+  }
+
+  /**
+   * \brief Gets the keys held down, indexed by evdev key code.
+   *
+   * \return The pressed key bitmap.
+   */
+  [[nodiscard]] const std::bitset<kMaxKeys>& get_pressed_keys() const {
+    return pressed_keys_;
+  }
+
+  /**
+   * \brief Gets the modifier and layout state after the last key event.
+   *
+   * \return The modifier state.
+   */
+  [[nodiscard]] const modifier_state& get_modifier_state() const {
+    return modifiers_;
+  }
+
+  /**
+   * \brief Checks if a modifier is active, whether held, latched or locked.
+   *
+   * \param modifier The modifier.
+   * \return True if active, false otherwise or if the keymap lacks it.
+   */
+  [[nodiscard]] bool is_modifier_active(Modifier modifier) const;
+
+  /**
+   * \brief Gets the keysym a key produces in the current state.
+   *
+   * Resolved from a table built per layout, falling back to xkb for keys
+   * with several keysyms or more than four levels.
+   *
+   * \param xkb_scancode The XKB scancode of the key.
+   * \return The keysym, or XKB_KEY_NoSymbol.
+   */
+  [[nodiscard]] xkb_keysym_t get_keysym(uint32_t xkb_scancode);
+
+  /**
+   * \brief Gets the UTF-32 character a key produces in the current state.
+   *
+   * Same lookup as get_keysym(). While Control or Caps Lock is active the
+   * xkb transformations apply, so xkb is asked directly.
+   *
+   * \param xkb_scancode The XKB scancode of the key.
+   * \return The character, or 0 if the key produces none.
+   */
+  [[nodiscard]] uint32_t get_utf32(uint32_t xkb_scancode);
+
   // Disallow copy and assign.
   Keyboard(const Keyboard&) = delete;
 
   Keyboard& operator=(const Keyboard&) = delete;
 
  private:
-  std::list<KeyboardObserver*> observers_{}; /**< List of observers */
-  std::mutex observers_mutex_{};             /**< Mutex for observers list */
-  void* user_data_{};                        /**< User data */
-  event_mask event_mask_{};                  /**< Event mask */
+  utils::ObserverList<KeyboardObserver> observers_{}; /**< Observers */
+  void* user_data_{};                                 /**< User data */
+  event_mask event_mask_{};                           /**< Event mask */
+
+  std::shared_ptr<KeymapCache> keymap_cache_; /**< Shared keymap cache */
+  std::shared_ptr<xkb_keymap> xkb_keymap_;    /**< XKB keymap */
+  xkb_state* xkb_state_{};                    /**< XKB state */
 
-  xkb_context* xkb_context_{}; /**< XKB context */
-  xkb_keymap* xkb_keymap_{};   /**< XKB keymap */
-  xkb_state* xkb_state_{};     /**< XKB state */
+  std::bitset<kMaxKeys> pressed_keys_{}; /**< Held keys by evdev code */
+  modifier_state modifiers_{};           /**< Serialized modifier state */
+  std::array<xkb_mod_index_t, MODIFIER_COUNT>
+      mod_indices_{}; /**< Keymap index of each Modifier */
+
+  static constexpr xkb_level_index_t kTableLevels = 4;
+
+  /**
+   * \brief Keysym and character of a key at one shift level.
+   */
+  struct key_level {
+    xkb_keysym_t keysym; /**< Keysym, or XKB_KEY_NoSymbol if not cached */
+    uint32_t utf32;      /**< UTF-32 character, or 0 */
+  };
 
   struct {
-    int32_t rate;        /**< Repeat rate */
-    int32_t delay;       /**< Repeat delay */
-    timer_t timer;       /**< Timer for key repeat */
-    uint32_t code;       /**< Key code */
-    sigevent sev;        /**< Signal event */
-    struct sigaction sa; /**< Signal action */
+    bool valid;                /**< Whether the table matches the layout */
+    xkb_layout_index_t layout; /**< Layout the table was built for */
+    xkb_keycode_t min_keycode; /**< Keycode of the first entry */
+    std::vector<std::array<key_level, kTableLevels>>
+        keys;     /**< Levels by keycode - min_keycode */
+  } key_table_{}; /**< Lookup table of the effective layout */
+
+  struct {
+    int32_t rate;   /**< Repeat interval in milliseconds */
+    int32_t delay;  /**< Repeat delay in milliseconds */
+    int fd = -1;    /**< Timer file descriptor for key repeat */
+    uint32_t count; /**< Repeats delivered for the current key */
 
     struct {
-      uint32_t serial;              /**< Serial number */
-      uint32_t time;                /**< Time of the event */
-      uint32_t xkb_scancode;        /**< XKB scancode */
-      int key_repeats;              /**< Key repeats */
-      int xdg_keysym_count;         /**< Key symbol count */
-      const xkb_keysym_t* key_syms; /**< Key symbols */
-    } notify;                       /**< Notification data */
-  } repeat_{};                      /**< Repeat data */
+      uint32_t time;         /**< Time of the press event */
+      uint32_t xkb_scancode; /**< XKB scancode */
+      int key_repeats;       /**< Key repeats */
+    } notify;                /**< Notification data */
+  } repeat_{};               /**< Repeat data */
 
   /**
-   * \brief Loads the default keymap.
+   * \brief Sets the keymap and creates a new XKB state for it.
+   *
+   * \param keymap The keymap to use.
    */
-  void load_default_keymap();
+  void set_keymap(std::shared_ptr<xkb_keymap> keymap);
+
+  /**
+   * \brief Builds the keysym table of the effective layout.
+   */
+  void build_key_table();
+
+  /**
+   * \brief Looks up a key in the keysym table.
+   *
+   * \param xkb_scancode The XKB scancode of the key.
+   * \return The cached level, or nullptr if xkb has to be asked.
+   */
+  const key_level* lookup_key(xkb_keycode_t xkb_scancode);
 
   /**
    * \brief Loads the keymap from a file.
@@ -212,17 +363,18 @@ class Keyboard {
   void handle_repeat_info(int32_t delay, int32_t rate);
 
   /**
-   * \brief Callback for key repeat events.
+   * \brief Arms or disarms the key repeat timer.
    *
-   * \param sig The signal number.
-   * \param si Pointer to the signal information.
-   * \param uc Pointer to the user context.
+   * \param arm Whether to arm the timer.
    */
-  static void repeat_xkb_v1_key_callback(int sig, siginfo_t* si, void* uc);
+  void set_repeat_timer(bool arm) const;
 
   /**
    * \brief Gets the file path for the keymap.
    *
+   * The layout is read from /etc/X11/xorg.conf.d, /etc/default/keyboard or
+   * /etc/vconsole.conf and resolved once per process.
+   *
    * \return A pair containing the keymap file path and the keymap file name.
    */
   static std::pair<std::string, std::string> get_keymap_filepath();
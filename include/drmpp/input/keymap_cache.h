@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_DRMPP_INPUT_KEYMAP_CACHE_H_
+#define INCLUDE_DRMPP_INPUT_KEYMAP_CACHE_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include <xkbcommon/xkbcommon.h>
+
+namespace drmpp::input {
+/**
+ * \brief Cache of compiled XKB keymaps sharing a single XKB context.
+ *
+ * Keymaps are compiled once per set of rule names and handed out as
+ * reference counted pointers, so each Keyboard only has to create its own
+ * xkb_state. The cache keeps a reference to every keymap it compiled for its
+ * own lifetime.
+ */
+class KeymapCache {
+ public:
+  /**
+   * \brief Constructs a KeymapCache instance and its XKB context.
+   */
+  KeymapCache();
+
+  /**
+   * \brief Destroys the KeymapCache instance.
+   */
+  ~KeymapCache();
+
+  /**
+   * \brief Gets the shared XKB context.
+   *
+   * \return Pointer to the XKB context.
+   */
+  [[nodiscard]] xkb_context* get_context() const { return xkb_context_; }
+
+  /**
+   * \brief Gets the keymap for a set of rule names, compiling it if needed.
+   *
+   * When no layout is given, or the keymap cannot be compiled from the
+   * installed XKB data, the built-in default keymap is returned.
+   *
+   * \param rules The XKB rules.
+   * \param model The XKB model.
+   * \param layout The XKB layout.
+   * \param variant The XKB variant.
+   * \param options The XKB options.
+   * \return A shared pointer to the keymap, or nullptr on failure.
+   */
+  std::shared_ptr<xkb_keymap> get_keymap(const char* rules,
+                                         const char* model,
+                                         const char* layout,
+                                         const char* variant,
+                                         const char* options);
+
+  /**
+   * \brief Gets the built-in default keymap, compiling it if needed.
+   *
+   * \return A shared pointer to the keymap, or nullptr on failure.
+   */
+  std::shared_ptr<xkb_keymap> get_default_keymap();
+
+  /**
+   * \brief Gets the number of cached keymaps.
+   *
+   * \return The number of cached keymaps.
+   */
+  [[nodiscard]] size_t size() const;
+
+  // Disallow copy and assign.
+  KeymapCache(const KeymapCache&) = delete;
+
+  KeymapCache& operator=(const KeymapCache&) = delete;
+
+ private:
+  /**
+   * \brief Cache key made of rules, model, layout, variant and options.
+   */
+  using Key = std::tuple<std::string,
+                         std::string,
+                         std::string,
+                         std::string,
+                         std::string>;
+
+  xkb_context* xkb_context_{}; /**< Shared XKB context */
+  std::shared_ptr<xkb_keymap> default_keymap_; /**< Built-in keymap */
+  std::map<Key, std::shared_ptr<xkb_keymap>> keymaps_; /**< Cached keymaps */
+  mutable std::mutex mutex_{}; /**< Mutex for the cache */
+
+  /**
+   * \brief Compiles the built-in default keymap.
+   *
+   * Must be called with mutex_ held.
+   *
+   * \return A shared pointer to the keymap, or nullptr on failure.
+   */
+  std::shared_ptr<xkb_keymap> load_default_keymap();
+
+  /**
+   * \brief Wraps a keymap in a shared pointer that releases it.
+   *
+   * \param keymap Pointer to the keymap.
+   * \return A shared pointer to the keymap, or nullptr.
+   */
+  static std::shared_ptr<xkb_keymap> wrap(xkb_keymap* keymap);
+};
+}  // namespace drmpp::input
+
+#endif  // INCLUDE_DRMPP_INPUT_KEYMAP_CACHE_H_
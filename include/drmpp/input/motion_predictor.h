@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_DRMPP_INPUT_MOTION_PREDICTOR_H_
+#define INCLUDE_DRMPP_INPUT_MOTION_PREDICTOR_H_
+
+#include <cstdint>
+
+namespace drmpp::input {
+/**
+ * \brief Predicts pointer or touch positions a short time ahead.
+ *
+ * Position and velocity are tracked with an alpha-beta filter, the steady
+ * state form of a constant velocity Kalman filter, fed with raw event
+ * timestamps. Predictions extrapolate with a velocity that decays
+ * exponentially, so overshoot stays bounded when motion stops.
+ */
+class MotionPredictor {
+ public:
+  /**
+   * \brief Struct representing the tuning of the predictor.
+   */
+  struct params {
+    double alpha = 0.6;                   /**< Position correction gain */
+    double beta = 0.2;                    /**< Velocity correction gain */
+    uint32_t velocity_decay_usec = 16000; /**< Velocity decay time constant */
+    uint32_t max_horizon_usec = 33000;    /**< Longest prediction */
+    uint32_t idle_reset_usec = 50000;     /**< Gap that restarts tracking */
+    double residual_scale = 4.0;          /**< Residual halving confidence */
+  };
+
+  /**
+   * \brief Struct representing a predicted position.
+   */
+  struct prediction {
+    double x;          /**< Predicted x-coordinate */
+    double y;          /**< Predicted y-coordinate */
+    double confidence; /**< Confidence in [0, 1], 0 if not predicted */
+  };
+
+  MotionPredictor() = default;
+
+  /**
+   * \brief Constructs a MotionPredictor instance.
+   *
+   * \param params The tuning of the predictor.
+   */
+  explicit MotionPredictor(const params& params) : params_(params) {}
+
+  /**
+   * \brief Sets the tuning of the predictor.
+   *
+   * \param params The tuning of the predictor.
+   */
+  void set_params(const params& params) { params_ = params; }
+
+  /**
+   * \brief Gets the tuning of the predictor.
+   *
+   * \return The tuning of the predictor.
+   */
+  [[nodiscard]] const params& get_params() const { return params_; }
+
+  /**
+   * \brief Adds a sampled position.
+   *
+   * \param time_usec The event time in microseconds.
+   * \param x The sampled x-coordinate.
+   * \param y The sampled y-coordinate.
+   */
+  void update(uint64_t time_usec, double x, double y);
+
+  /**
+   * \brief Predicts the position at a target time.
+   *
+   * \param target_usec The target time in microseconds, on the clock of the
+   * event timestamps, e.g. the next vblank from Output::EstimateNextVblank().
+   * \return The predicted position. When there is not enough recent motion
+   * the last position is returned with a confidence of 0.
+   */
+  [[nodiscard]] prediction predict(uint64_t target_usec) const;
+
+  /**
+   * \brief Discards the tracked motion.
+   */
+  void reset();
+
+ private:
+  params params_{}; /**< Tuning */
+
+  struct {
+    double x;           /**< Filtered x-coordinate */
+    double y;           /**< Filtered y-coordinate */
+    double vx;          /**< Filtered x velocity per second */
+    double vy;          /**< Filtered y velocity per second */
+    double residual;    /**< Smoothed prediction error */
+    uint64_t time_usec; /**< Time of the last sample */
+    uint32_t samples;   /**< Samples since the last reset */
+  } state_{};           /**< Filter state */
+};
+}  // namespace drmpp::input
+
+#endif  // INCLUDE_DRMPP_INPUT_MOTION_PREDICTOR_H_
@@ -18,8 +18,6 @@
 #define INCLUDE_DRMPP_INPUT_POINTER_H_
 
 #include <cursor/xcursor.h>
-#include <list>
-#include <mutex>
 #include <optional>
 #include <string>
 #include <vector>
@@ -28,6 +26,9 @@ extern "C" {
 #include <libinput.h>
 }
 
+#include "input/motion_predictor.h"
+#include "utils/observer_list.h"
+
 namespace drmpp::input {
 class Pointer;
 
@@ -116,6 +117,18 @@ class PointerObserver {
   virtual void notify_pointer_axis_discrete(Pointer* pointer,
                                             uint32_t axis,
                                             int32_t discrete) = 0;
+
+  /**
+   * \brief Notify the observer that the cursor changed.
+   *
+   * Pass the images to a hardware cursor such as CursorPlane::SetCursor.
+   *
+   * \param pointer Pointer to the Pointer instance.
+   * \param images The images of the new cursor.
+   */
+  virtual void notify_pointer_cursor(
+      Pointer* /* pointer */,
+      const std::shared_ptr<XCursor::Images>& /* images */) {}
 };
 
 /**
@@ -125,6 +138,16 @@ class Pointer {
  public:
   static constexpr int kResizeMargin = 10;
 
+  /**
+   * \brief Struct representing a motion sample merged by coalescing.
+   */
+  struct motion_sample {
+    uint32_t time; /**< Time of the event */
+    double x;      /**< Relative delta or absolute x-coordinate */
+    double y;      /**< Relative delta or absolute y-coordinate */
+    bool absolute; /**< Whether the sample is an absolute position */
+  };
+
   /**
    * \brief Struct representing the event mask.
    */
@@ -159,7 +182,7 @@ class Pointer {
    * \param user_data Optional user data to be passed to the observer.
    */
   void register_observer(PointerObserver* observer, void* user_data = nullptr) {
-    observers_.push_back(observer);
+    observers_.add(observer);
 
     if (user_data) {
       user_data_ = user_data;
@@ -192,6 +215,9 @@ class Pointer {
   /**
    * \brief Gets the cursor theme.
    *
+   * Resolved once per process from XCURSOR_THEME, the GTK settings and the
+   * default index.theme, falling back to "default".
+   *
    * \return A string containing the cursor theme.
    */
   static std::string get_cursor_theme();
@@ -199,6 +225,9 @@ class Pointer {
   /**
    * \brief Gets the available cursors for the specified theme.
    *
+   * Includes the cursors of inherited themes. The theme index is built once
+   * per theme.
+   *
    * \param theme_name The name of the cursor theme (optional).
    * \return A vector of strings containing the available cursors.
    */
@@ -208,13 +237,34 @@ class Pointer {
   /**
    * \brief Sets the cursor.
    *
+   * Looks the cursor up in the theme and its parents, prepared at the
+   * pointer size times the cursor scale. The current cursor is kept if not
+   * found.
+   *
    * \param serial The serial number of the event.
    * \param cursor_name The name of the cursor (default is "right_ptr").
    * \param theme_name The name of the cursor theme (optional).
    */
   void set_cursor(uint32_t serial,
                   const char* cursor_name = "right_ptr",
-                  const char* theme_name = nullptr) const;
+                  const char* theme_name = nullptr);
+
+  /**
+   * \brief Sets the scale of the output the cursor is shown on.
+   *
+   * The current cursor is prepared again for the scale.
+   *
+   * \param serial The serial number of the event.
+   * \param scale The output scale, 2.0 for a HiDPI output.
+   */
+  void set_cursor_scale(uint32_t serial, double scale);
+
+  /**
+   * \brief Gets the scale the cursor is prepared for.
+   *
+   * \return The cursor scale.
+   */
+  [[nodiscard]] double get_cursor_scale() const { return scale_; }
 
   /**
    * \brief Checks if the cursor is enabled.
@@ -223,6 +273,15 @@ class Pointer {
    */
   [[nodiscard]] bool is_cursor_enabled() const { return !disable_cursor_; }
 
+  /**
+   * \brief Gets the images of the current cursor.
+   *
+   * \return A shared pointer to the images, or nullptr if none is loaded.
+   */
+  [[nodiscard]] std::shared_ptr<XCursor::Images> get_cursor_images() const {
+    return cursor_;
+  }
+
   /**
    * \brief Sets the event mask.
    *
@@ -237,6 +296,69 @@ class Pointer {
    */
   [[nodiscard]] std::pair<double, double> get_xy() const { return {sx_, sy_}; }
 
+  /**
+   * \brief Sets the output resolution the pointer position is mapped to.
+   *
+   * Relative motion is clamped to the output and absolute positions are
+   * scaled to it. Without an output size absolute positions are in mm and
+   * relative motion is not clamped.
+   *
+   * \param width The output width in pixels, or 0.
+   * \param height The output height in pixels, or 0.
+   */
+  void set_output_size(uint32_t width, uint32_t height);
+
+  /**
+   * \brief Enables or disables motion prediction.
+   *
+   * \param enable Whether to track motion for prediction.
+   * \param params The tuning of the predictor for this device.
+   */
+  void set_prediction(bool enable, const MotionPredictor::params& params = {});
+
+  /**
+   * \brief Predicts the pointer position at a target time.
+   *
+   * \param target_usec The target time in microseconds, typically from
+   * Output::EstimateNextVblank().
+   * \return The predicted position, or the current position with a
+   * confidence of 0 when prediction is disabled.
+   */
+  [[nodiscard]] MotionPredictor::prediction predict(
+      uint64_t target_usec) const;
+
+  /**
+   * \brief Enables or disables per-frame motion coalescing.
+   *
+   * While enabled, motion events are not forwarded immediately. Relative
+   * deltas are summed and the last absolute position is kept until
+   * flush_motion() delivers a single combined event.
+   *
+   * \param enable Whether to coalesce motion events.
+   * \param keep_history Whether to keep every merged sample.
+   */
+  void set_motion_coalescing(bool enable, bool keep_history = false);
+
+  /**
+   * \brief Delivers the motion accumulated since the last flush.
+   *
+   * Call once per frame when coalescing is enabled. Pending motion is also
+   * flushed before a button or axis event to preserve ordering.
+   */
+  void flush_motion();
+
+  /**
+   * \brief Gets the samples merged into the event being delivered.
+   *
+   * Only populated when history is enabled. Valid from within the observer
+   * callbacks of flush_motion().
+   *
+   * \return The full-resolution motion samples.
+   */
+  [[nodiscard]] const std::vector<motion_sample>& get_motion_history() const {
+    return motion_history_;
+  }
+
   /**
    * \brief Handles a pointer button event.
    *
@@ -265,6 +387,52 @@ class Pointer {
    */
   void handle_pointer_motion_absolute_event(libinput_event_pointer* ev);
 
+  /**
+   * \brief Handles a decoded pointer button event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param button The button code.
+   * \param state The state of the button.
+   */
+  void handle_pointer_button(uint32_t time, uint32_t button, uint32_t state);
+
+  /**
+   * \brief Handles a decoded relative pointer motion event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param dx The x delta.
+   * \param dy The y delta.
+   * \param time_usec The time of the event in microseconds, or 0.
+   */
+  void handle_pointer_motion(uint32_t time,
+                             double dx,
+                             double dy,
+                             uint64_t time_usec = 0);
+
+  /**
+   * \brief Handles a decoded pointer axis event.
+   *
+   * \param source The axis source.
+   */
+  void handle_pointer_axis_source(uint32_t source);
+
+  /**
+   * \brief Handles a decoded absolute pointer motion event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param x The absolute x-coordinate in mm.
+   * \param y The absolute y-coordinate in mm.
+   * \param nx The absolute x-coordinate normalized to [0, 1].
+   * \param ny The absolute y-coordinate normalized to [0, 1].
+   * \param time_usec The time of the event in microseconds, or 0.
+   */
+  void handle_pointer_motion_absolute(uint32_t time,
+                                      double x,
+                                      double y,
+                                      double nx,
+                                      double ny,
+                                      uint64_t time_usec = 0);
+
   // Disallow copy and assign.
   Pointer(const Pointer&) = delete;
 
@@ -295,16 +463,42 @@ class Pointer {
     int32_t y; /**< y-coordinate */
   };
 
-  std::list<PointerObserver*> observers_{}; /**< List of observers */
-  std::mutex observers_mutex_{};            /**< Mutex for observers list */
+  utils::ObserverList<PointerObserver> observers_{}; /**< Observers */
   bool disable_cursor_; /**< Whether the cursor is disabled */
   void* user_data_{};   /**< User data */
 
-  std::unique_ptr<XCursor::Images> cursor_;
+  uint32_t size_;                           /**< Nominal cursor size */
+  double scale_{1.0};                       /**< Output scale */
+  std::string cursor_name_;                 /**< Name of the current cursor */
+  std::string cursor_theme_;                /**< Theme of the current cursor */
+  std::shared_ptr<XCursor::Images> cursor_; /**< Current cursor */
 
   double sx_{}; /**< x-coordinate of the pointer */
   double sy_{}; /**< y-coordinate of the pointer */
 
+  struct {
+    uint32_t width;  /**< Output width in pixels */
+    uint32_t height; /**< Output height in pixels */
+  } output_{};       /**< Output the position is mapped to */
+
+  bool predict_{};              /**< Whether motion is predicted */
+  MotionPredictor predictor_{}; /**< Motion predictor */
+
+  struct {
+    bool enabled;      /**< Whether motion is coalesced */
+    bool keep_history; /**< Whether merged samples are kept */
+    bool relative;     /**< Whether relative motion is pending */
+    uint32_t time;     /**< Time of the last relative event */
+    double dx;         /**< Accumulated x delta */
+    double dy;         /**< Accumulated y delta */
+    bool absolute;     /**< Whether absolute motion is pending */
+    uint32_t abs_time; /**< Time of the last absolute event */
+    double x;          /**< Last absolute x-coordinate */
+    double y;          /**< Last absolute y-coordinate */
+  } coalesce_{};       /**< Motion coalescing state */
+
+  std::vector<motion_sample> motion_history_{}; /**< Merged samples */
+
 #if ENABLE_XDG_CLIENT
   enum xdg_toplevel_resize_edge prev_resize_edge_ =
       XDG_TOPLEVEL_RESIZE_EDGE_NONE; /**< Previous resize edge */
@@ -17,21 +17,33 @@
 #ifndef INCLUDE_DRMPP_INPUT_SEAT_H_
 #define INCLUDE_DRMPP_INPUT_SEAT_H_
 
-#include <list>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <fcntl.h>
 #include <libinput.h>
+#include <sys/epoll.h>
 #include <unistd.h>
 
 #include "drmpp.h"
+#include "input/event_recorder.h"
+#include "input/gesture.h"
+#include "input/tablet.h"
+#include "utils/observer_list.h"
+#include "utils/spsc_ring.h"
 
 namespace drmpp::input {
 class Seat;
 class Keyboard;
+class KeymapCache;
 class Pointer;
 class Touch;
 
@@ -76,6 +88,26 @@ class Seat {
     Keyboard::event_mask keyboard; /**< Keyboard event mask */
     Pointer::event_mask pointer;   /**< Pointer event mask */
     Touch::event_mask touch;       /**< Touch event mask */
+    Tablet::event_mask tablet;     /**< Tablet event mask */
+    Gesture::event_mask gesture;   /**< Gesture event mask */
+  };
+
+  /**
+   * \brief Identifies the newest input event consumed by the seat.
+   */
+  struct input_token {
+    uint64_t time_usec; /**< CLOCK_MONOTONIC event time in microseconds */
+    uint64_t sequence;  /**< Number of timestamped events consumed */
+  };
+
+  /**
+   * \brief Counters of the messages logged by libinput.
+   */
+  struct log_stats {
+    uint64_t debug;      /**< Debug messages */
+    uint64_t info;       /**< Info messages */
+    uint64_t error;      /**< Error messages */
+    uint64_t suppressed; /**< Messages dropped by the rate limit */
   };
 
   /**
@@ -89,11 +121,46 @@ class Seat {
                 const char* ignore_events,
                 const char* seat_id = "seat0");
 
+  /**
+   * \brief Constructs a Seat instance whose devices are added explicitly.
+   *
+   * The seat uses a libinput path context and does not watch udev itself.
+   * Devices are assigned with add_path_device(), typically by a SeatManager.
+   *
+   * \param keymap_cache Shared keymap cache, or nullptr to create one.
+   * \param seat_id The ID of the seat.
+   * \param disable_cursor Whether to disable the cursor.
+   * \param ignore_events The events to be ignored.
+   */
+  Seat(std::shared_ptr<KeymapCache> keymap_cache,
+       const char* seat_id,
+       bool disable_cursor = false,
+       const char* ignore_events = nullptr);
+
   /**
    * \brief Destroys the Seat instance.
    */
   ~Seat();
 
+  /**
+   * \brief Adds an evdev device to a seat created without udev.
+   *
+   * Must not be called while the input thread runs.
+   *
+   * \param dev_node The device node, e.g. /dev/input/event3.
+   * \return True if the device was added, false otherwise.
+   */
+  bool add_path_device(const char* dev_node);
+
+  /**
+   * \brief Removes a device added with add_path_device().
+   *
+   * Must not be called while the input thread runs.
+   *
+   * \param dev_node The device node.
+   */
+  void remove_path_device(const char* dev_node);
+
   /**
    * \brief Registers an observer for seat events.
    *
@@ -116,6 +183,93 @@ class Seat {
    */
   bool run_once();
 
+  /**
+   * \brief Drains all pending libinput events in a single pass.
+   *
+   * libinput_dispatch is called once, then every queued event is handled.
+   * When a budget is given, the drain stops once it has been exceeded; the
+   * remaining events stay queued for the next call.
+   *
+   * \param budget Maximum time to spend handling events (zero is unbounded).
+   * \return The number of events handled.
+   */
+  size_t dispatch_all(
+      std::chrono::microseconds budget = std::chrono::microseconds::zero());
+
+  /**
+   * \brief Waits for input and drains all pending events.
+   *
+   * Blocks on the seat's epoll descriptor until input is available or the
+   * timeout expires, then handles everything that is queued. A timeout of
+   * zero polls without blocking, -1 waits indefinitely.
+   *
+   * \param timeout_ms The maximum time to wait in milliseconds.
+   * \return The number of events handled, or -1 on error.
+   */
+  int wait_and_dispatch(int timeout_ms = -1);
+
+  /**
+   * \brief Gets the libinput file descriptor.
+   *
+   * \return The file descriptor returned by libinput_get_fd.
+   */
+  [[nodiscard]] int get_fd() const { return libinput_get_fd(li_); }
+
+  /**
+   * \brief Gets the seat epoll file descriptor.
+   *
+   * The descriptor becomes readable whenever the seat has work to do, either
+   * libinput events or key repeats. It can be nested in an external epoll set
+   * or polled directly.
+   *
+   * \return The epoll file descriptor.
+   */
+  [[nodiscard]] int get_epoll_fd() const { return epoll_fd_; }
+
+  /**
+   * \brief Registers the seat with an external epoll loop.
+   *
+   * The seat epoll descriptor is added with data.ptr set to this seat. When
+   * the external loop reports it readable, call wait_and_dispatch(0).
+   *
+   * \param epoll_fd The external epoll file descriptor.
+   * \return True if the seat was registered, false otherwise.
+   */
+  bool attach_to_epoll(int epoll_fd);
+
+  /**
+   * \brief Removes the seat from an external epoll loop.
+   *
+   * \param epoll_fd The external epoll file descriptor.
+   */
+  void detach_from_epoll(int epoll_fd) const;
+
+  /**
+   * \brief Gets the number of events handled by the last dispatch_all call.
+   *
+   * \return The number of events handled.
+   */
+  [[nodiscard]] size_t get_last_dispatch_count() const {
+    return last_dispatch_count_;
+  }
+
+  /**
+   * \brief Gets the total number of events handled by this seat.
+   *
+   * \return The number of events handled.
+   */
+  [[nodiscard]] uint64_t get_events_handled() const { return events_handled_; }
+
+  /**
+   * \brief Gets the token of the newest input event dispatched.
+   *
+   * Pass the time of the token to Output::SubmitFrame() when submitting a
+   * frame that reflects the input, to measure input-to-scanout latency.
+   *
+   * \return The input token.
+   */
+  [[nodiscard]] input_token get_input_token() const { return input_token_; }
+
   /**
    * \brief Gets the user data.
    *
@@ -139,6 +293,15 @@ class Seat {
    */
   [[nodiscard]] const std::string& get_name() const { return name_; }
 
+  /**
+   * \brief Gets the keymap cache shared by the keyboards of the seat.
+   *
+   * \return A shared pointer to the keymap cache.
+   */
+  [[nodiscard]] const std::shared_ptr<KeymapCache>& get_keymap_cache() const {
+    return keymap_cache_;
+  }
+
   /**
    * \brief Gets the keyboards associated with the seat.
    *
@@ -156,13 +319,200 @@ class Seat {
    */
   [[nodiscard]] std::optional<std::shared_ptr<Pointer>> get_pointer() const;
 
+  /**
+   * \brief Gets the touch device associated with the seat.
+   *
+   * \return An optional shared pointer to a Touch instance.
+   */
+  [[nodiscard]] std::optional<std::shared_ptr<Touch>> get_touch() const;
+
+  /**
+   * \brief Gets the tablet tools associated with the seat.
+   *
+   * \return An optional shared pointer to a Tablet instance.
+   */
+  [[nodiscard]] std::optional<std::shared_ptr<Tablet>> get_tablet() const;
+
+  /**
+   * \brief Gets the touchpad gestures associated with the seat.
+   *
+   * \return An optional shared pointer to a Gesture instance.
+   */
+  [[nodiscard]] std::optional<std::shared_ptr<Gesture>> get_gesture() const;
+
+  /**
+   * \brief Enables or disables per-frame motion coalescing.
+   *
+   * Applies to the current and any later pointer, touch, tablet and gesture
+   * devices. Gestures do not keep history.
+   *
+   * \param enable Whether to coalesce motion events.
+   * \param keep_history Whether to keep every merged sample.
+   */
+  void set_motion_coalescing(bool enable, bool keep_history = false);
+
+  /**
+   * \brief Sets the output resolution pointer, touch and tablets are mapped
+   * to.
+   *
+   * Applies to the current and any later pointer, touch and tablet devices.
+   * Typically the size of the Output the seat is attached to.
+   *
+   * \param width The output width in pixels, or 0 to report mm.
+   * \param height The output height in pixels, or 0 to report mm.
+   */
+  void set_output_size(uint32_t width, uint32_t height);
+
+  /**
+   * \brief Delivers coalesced pointer, touch, tablet and gesture motion.
+   *
+   * Call once per frame, at the frame boundary, when coalescing is enabled.
+   */
+  void flush_motion() const;
+
   /**
    * \brief Sets the event mask.
    *
+   * Masked events are dropped before they are decoded, recorded or queued
+   * for the input thread.
+   *
    * \param ignore_events The events to be ignored.
    */
   void set_event_mask(const char* ignore_events);
 
+  /**
+   * \brief Disables devices whose events are all masked.
+   *
+   * When enabled, libinput stops processing devices for which every
+   * capability the seat uses is masked, through the send-events
+   * configuration. Devices are re-enabled when the mask no longer covers them
+   * or this is turned off.
+   *
+   * \param enable Whether to disable fully masked devices.
+   */
+  void set_disable_masked_devices(bool enable);
+
+  /**
+   * \brief Gets the number of events dropped by the event mask.
+   *
+   * \return The number of masked events.
+   */
+  [[nodiscard]] uint64_t get_events_masked() const { return events_masked_; }
+
+  /**
+   * \brief Gets the number of events the seat has no handler for.
+   *
+   * \return The number of unhandled events.
+   */
+  [[nodiscard]] uint64_t get_events_unhandled() const {
+    return events_unhandled_;
+  }
+
+  /**
+   * \brief Gets the counters of libinput log messages.
+   *
+   * Every message is counted. Release builds only print errors, and at most
+   * a burst of messages per second is printed per thread.
+   *
+   * \return The log counters.
+   */
+  [[nodiscard]] log_stats get_log_stats() const;
+
+  /**
+   * \brief Starts a dedicated input thread.
+   *
+   * The thread runs libinput dispatch and event decoding, and pushes
+   * EventRecords into a lock-free single-producer/single-consumer ring.
+   * Observers are still notified on the thread calling drain_input(),
+   * dispatch_all(), run_once() or wait_and_dispatch(), which drain the ring
+   * instead of libinput while the thread runs. Keymaps of new keyboards are
+   * compiled on the input thread.
+   *
+   * Key records carry the raw key code. The xkb_state update, keysym and
+   * UTF-32 lookup and key repeat stay with the Keyboard on the consuming
+   * thread. The state is shared with set_keymap, the modifier getters and
+   * the repeat timer, which all run there. A key costs about a microsecond
+   * of XKB work, and recorded traces stay independent of the keymap.
+   *
+   * Recording must be started or stopped while the thread is not running.
+   *
+   * \return True on success, false otherwise.
+   */
+  bool start_input_thread();
+
+  /**
+   * \brief Stops the input thread and delivers the records it queued.
+   */
+  void stop_input_thread();
+
+  /**
+   * \brief Delivers the records queued by the input thread.
+   *
+   * Intended to be called once per frame from the render loop. Also delivers
+   * the key repeats whose timer fired. Records left over by max_events or
+   * the budget stay queued for the next call.
+   *
+   * \param max_events The maximum number of records to deliver, or 0 for all.
+   * \param budget Maximum time to spend delivering records (zero is
+   * unbounded).
+   * \return The number of records delivered.
+   */
+  size_t drain_input(size_t max_events = 0,
+                     std::chrono::microseconds budget = {});
+
+  /**
+   * \brief Gets a descriptor that becomes readable when records are queued.
+   *
+   * \return The eventfd, or -1 when the input thread is not running.
+   */
+  [[nodiscard]] int get_input_ready_fd() const { return input_ready_fd_; }
+
+  /**
+   * \brief Gets how often the input thread found the ring full.
+   *
+   * \return The number of stalls.
+   */
+  [[nodiscard]] uint64_t get_input_ring_stalls() const {
+    return input_ring_stalls_;
+  }
+
+  /**
+   * \brief Starts recording dispatched events into a trace file.
+   *
+   * \param path The path of the trace file.
+   * \return True on success, false otherwise.
+   */
+  bool start_recording(const std::string& path);
+
+  /**
+   * \brief Stops recording and finalizes the trace file.
+   */
+  void stop_recording();
+
+  /**
+   * \brief Checks if dispatched events are being recorded.
+   *
+   * \return True if recording, false otherwise.
+   */
+  [[nodiscard]] bool is_recording() const { return recorder_ != nullptr; }
+
+  /**
+   * \brief Dispatches a decoded event record.
+   *
+   * Records are routed through the same handlers as libinput events. Device
+   * added records create the Keyboard, Pointer, Touch, Tablet and Gesture
+   * handlers, so this is used to replay traces without input hardware. Key
+   * records are routed to the keyboard of their device, or to every keyboard
+   * when the device is 0. Recorded device ids are kept apart from the ids of
+   * live devices.
+   *
+   * For reproducible replays, use a seat built with the path constructor
+   * and no devices added, so no live device injects events.
+   *
+   * \param record The event record.
+   */
+  void handle_record(const EventRecord& record);
+
   // Disallow copy and assign.
   Seat(const Seat&) = delete;
 
@@ -171,6 +521,7 @@ class Seat {
  private:
   libinput* li_{}; /**< libinput context */
   udev* udev_{};   /**< udev context */
+  int epoll_fd_ = -1; /**< Seat epoll file descriptor */
 
   uint32_t capabilities_{};       /**< Capabilities of the seat */
   bool capabilities_init_ = true; /**< Whether capabilities are initialized */
@@ -178,13 +529,256 @@ class Seat {
   bool disable_cursor_;           /**< Whether the cursor is disabled */
   void* user_data_{};             /**< User data */
   event_mask event_mask_{};       /**< Event mask */
+  size_t last_dispatch_count_{};  /**< Events handled by last dispatch_all */
+  uint64_t events_handled_{};     /**< Total events handled */
+  uint64_t events_unhandled_{};   /**< Events without a handler */
+  input_token input_token_{};     /**< Newest input event dispatched */
+
+  /**
+   * \brief Event classes dropped before decoding.
+   */
+  enum masked_event : uint32_t {
+    MASKED_KEYBOARD = 1U << 0,       /**< Keyboard keys */
+    MASKED_POINTER_BUTTON = 1U << 1, /**< Pointer buttons */
+    MASKED_POINTER_MOTION = 1U << 2, /**< Relative and absolute motion */
+    MASKED_POINTER_AXIS = 1U << 3,   /**< Pointer axis */
+    MASKED_TOUCH = 1U << 4,          /**< All touch events */
+    MASKED_TABLET = 1U << 5,         /**< All tablet tool events */
+    MASKED_GESTURE = 1U << 6,        /**< All gesture events */
+  };
+
+  std::atomic<uint32_t> masked_events_{};      /**< Active masked_event bits */
+  std::atomic<uint64_t> events_masked_{};      /**< Events dropped by mask */
+  std::atomic<bool> disable_masked_devices_{}; /**< Disable masked devices */
+  std::atomic<bool> send_events_dirty_{};      /**< Device modes are stale */
+
+  std::atomic<uint64_t> log_debug_{};      /**< libinput debug messages */
+  std::atomic<uint64_t> log_info_{};       /**< libinput info messages */
+  std::atomic<uint64_t> log_error_{};      /**< libinput error messages */
+  std::atomic<uint64_t> log_suppressed_{}; /**< Messages over the limit */
+
+  /**
+   * \brief Device state owned by the thread that reads libinput.
+   *
+   * The entry is set as the libinput device user data, so events find their
+   * device id without a lookup.
+   */
+  struct device_info {
+    uint16_t id;   /**< Seat device id carried in EventRecord::device */
+    bool disabled; /**< Whether the seat disabled the device */
+  };
+
+  /**
+   * \brief Per-device handler state on the dispatching thread.
+   */
+  struct device_state {
+    uint32_t caps;      /**< SeatObserver capabilities of the device */
+    Keyboard* keyboard; /**< Keyboard owned by the device, or nullptr */
+  };
+
+  std::map<libinput_device*, device_info>
+      devices_;               /**< Referenced devices by libinput device */
+  /// Set in the ids of replayed devices, never in those of live devices
+  static constexpr uint16_t kReplayDeviceBit = 0x8000;
+  uint16_t last_device_id_{}; /**< Last device id handed out */
+  std::map<uint16_t, device_state>
+      device_states_;         /**< Dispatch side registry by device id */
+  std::map<std::string, libinput_device*>
+      path_devices_; /**< Devices added by node, path context only */
+
+  struct {
+    bool enabled;      /**< Whether motion is coalesced */
+    bool keep_history; /**< Whether merged samples are kept */
+  } coalesce_{};       /**< Motion coalescing settings */
+
+  struct {
+    uint32_t width;  /**< Output width in pixels */
+    uint32_t height; /**< Output height in pixels */
+  } output_{};       /**< Output pointer and touch are mapped to */
 
-  std::list<SeatObserver*> observers_{}; /**< List of observers */
-  std::mutex observers_mutex_{};         /**< Mutex for observers list */
+  utils::ObserverList<SeatObserver> observers_{}; /**< Observers */
+  std::shared_ptr<KeymapCache> keymap_cache_;     /**< Shared keymap cache */
   std::shared_ptr<std::vector<std::unique_ptr<Keyboard>>>
       keyboards_;                    /**< Keyboards associated with the seat */
   std::shared_ptr<Pointer> pointer_; /**< Pointer associated with the seat */
   std::shared_ptr<Touch> touch_;     /**< Touch associated with the seat */
+  std::shared_ptr<Tablet> tablet_;   /**< Tablet tools of the seat */
+  std::shared_ptr<Gesture> gesture_; /**< Touchpad gestures of the seat */
+
+  std::unique_ptr<EventRecorder> recorder_; /**< Active event recorder */
+
+  /**
+   * \brief XKB rule names of a keyboard device.
+   */
+  struct xkb_names {
+    std::string model;   /**< XKB model */
+    std::string layout;  /**< XKB layout */
+    std::string variant; /**< XKB variant */
+    std::string options; /**< XKB options */
+  };
+
+  static constexpr size_t kInputRingSize = 4096;
+
+  std::thread input_thread_;                  /**< Input thread */
+  std::atomic<bool> input_running_{};         /**< Whether the thread runs */
+  std::atomic<uint64_t> input_ring_stalls_{}; /**< Pushes into a full ring */
+  int input_wake_fd_ = -1;                    /**< Wakes the input thread */
+  int input_ready_fd_ = -1;                   /**< Signals queued records */
+  std::unique_ptr<utils::SpscRing<EventRecord, kInputRingSize>>
+      input_ring_; /**< Records from the input thread */
+  std::map<uint16_t, xkb_names>
+      pending_names_;              /**< Keyboard names by device id */
+  std::mutex pending_names_mutex_; /**< Mutex for pending_names_ */
+
+  /**
+   * \brief Waits on the seat epoll set and services key repeat timers.
+   *
+   * \param timeout_ms The maximum time to wait in milliseconds.
+   * \return The number of ready descriptors, or -1 on error.
+   */
+  int poll_fds(int timeout_ms) const;
+
+  /**
+   * \brief Delivers the records queued by the input thread.
+   *
+   * \param max_events The maximum number of records to deliver, or 0 for all.
+   * \param budget Maximum time to spend delivering records (zero is
+   * unbounded).
+   * \return The number of records delivered.
+   */
+  size_t drain_ring(size_t max_events, std::chrono::microseconds budget);
+
+  /**
+   * \brief Sets up logging, the epoll set and the event mask of li_.
+   *
+   * \param keymap_cache The keymap cache for the keyboards of the seat.
+   * \param ignore_events The events to be ignored.
+   */
+  void init_context(std::shared_ptr<KeymapCache> keymap_cache,
+                    const char* ignore_events);
+
+  /**
+   * \brief Tracks devices and drops masked events before decoding.
+   *
+   * Must be called on the thread that owns the libinput context.
+   *
+   * \param ev Pointer to the libinput event.
+   * \return True if the event is masked, false otherwise.
+   */
+  bool filter_event(libinput_event* ev);
+
+  /**
+   * \brief Registers a libinput device and assigns it a device id.
+   *
+   * \param dev The libinput device.
+   * \return The device entry.
+   */
+  device_info& add_device(libinput_device* dev);
+
+  /**
+   * \brief Drops the seat reference to a removed libinput device.
+   *
+   * \param dev The libinput device.
+   */
+  void release_device(libinput_device* dev);
+
+  /**
+   * \brief Checks if events of a type are masked.
+   *
+   * \param type The libinput event type.
+   * \return True if masked, false otherwise.
+   */
+  [[nodiscard]] bool is_masked(libinput_event_type type) const;
+
+  /**
+   * \brief Recomputes masked_events_ from the event mask.
+   */
+  void update_masked_events();
+
+  /**
+   * \brief Applies the send-events mode to every tracked device.
+   *
+   * Runs directly, or on the input thread while it is running.
+   */
+  void refresh_send_events();
+
+  /**
+   * \brief Enables or disables a device according to the event mask.
+   *
+   * \param dev The libinput device.
+   * \param disabled Whether the seat has disabled the device.
+   */
+  void apply_send_events(libinput_device* dev, bool& disabled) const;
+
+  /**
+   * \brief Handles a single libinput event.
+   *
+   * \param ev Pointer to the libinput event.
+   */
+  void handle_event(libinput_event* ev);
+
+  /**
+   * \brief Decodes a libinput event into an event record.
+   *
+   * \param ev Pointer to the libinput event.
+   * \return The event record.
+   */
+  static EventRecord decode_event(libinput_event* ev);
+
+  /**
+   * \brief Reads the XKB rule names of a device from udev.
+   *
+   * \param dev The libinput device.
+   * \return The XKB rule names.
+   */
+  static xkb_names get_xkb_names(libinput_device* dev);
+
+  /**
+   * \brief Runs libinput dispatch on the input thread.
+   */
+  void input_thread_main();
+
+  /**
+   * \brief Signals the input thread to exit and joins it.
+   */
+  void join_input_thread();
+
+  /**
+   * \brief Dispatches an event record to the handlers.
+   *
+   * \param record The event record.
+   * \param dev The libinput device, or nullptr when replaying.
+   */
+  void dispatch_record(const EventRecord& record, libinput_device* dev);
+
+  /**
+   * \brief Creates the handlers for a newly added device.
+   *
+   * \param record The device added record.
+   * \param dev The libinput device, or nullptr when replaying.
+   */
+  void handle_device_added(const EventRecord& record, libinput_device* dev);
+
+  /**
+   * \brief Frees the handlers of a removed device.
+   *
+   * \param record The device removed record.
+   * \param dev The libinput device, or nullptr when replaying.
+   */
+  void handle_device_removed(const EventRecord& record, libinput_device* dev);
+
+  /**
+   * \brief Notifies observers of the current seat capabilities.
+   */
+  void notify_capabilities();
+
+  /**
+   * \brief Gets the capabilities the seat uses from a device.
+   *
+   * \param dev The libinput device.
+   * \return The SeatObserver capabilities of the device.
+   */
+  static uint32_t get_device_capabilities(libinput_device* dev);
 
   /**
    * \brief Handles seat capabilities.
@@ -202,6 +796,19 @@ class Seat {
    */
   static void handle_name(void* data, const char* name);
 
+  /**
+   * \brief Counts, rate limits and prints a libinput log message.
+   *
+   * \param li The libinput context, its user data is the seat.
+   * \param priority The message priority.
+   * \param format The printf format of the message.
+   * \param args The format arguments.
+   */
+  static void handle_log(libinput* li,
+                         libinput_log_priority priority,
+                         const char* format,
+                         va_list args);
+
   /**
    * \brief Prints the event mask.
    */
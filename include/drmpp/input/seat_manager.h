@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_DRMPP_INPUT_SEAT_MANAGER_H_
+#define INCLUDE_DRMPP_INPUT_SEAT_MANAGER_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <libudev.h>
+
+#include "utils/observer_list.h"
+
+class Output;
+
+namespace drmpp::input {
+class KeymapCache;
+class Seat;
+class SeatManager;
+
+/**
+ * \brief Interface for observing seats created by a SeatManager.
+ */
+class SeatManagerObserver {
+ public:
+  virtual ~SeatManagerObserver() = default;
+
+  /**
+   * \brief Notify the observer of a new seat.
+   *
+   * Called before the first device of the seat is dispatched, so seat
+   * observers registered here see the initial capabilities.
+   *
+   * \param seat_manager Pointer to the SeatManager instance.
+   * \param seat Pointer to the new Seat instance.
+   */
+  virtual void notify_seat_added(SeatManager* seat_manager, Seat* seat) = 0;
+};
+
+/**
+ * \brief Routes input devices to seats by their udev ID_SEAT property.
+ *
+ * A single udev monitor watches the input subsystem for the whole system.
+ * Each seat found gets its own libinput path context, and all seats share
+ * one KeymapCache. Every seat is driven from the thread calling
+ * wait_and_dispatch(), through a single epoll set.
+ */
+class SeatManager {
+ public:
+  /**
+   * \brief Constructs a SeatManager instance.
+   *
+   * \param disable_cursor Whether seats disable the cursor.
+   * \param ignore_events The events ignored by every seat.
+   */
+  explicit SeatManager(bool disable_cursor = false,
+                       const char* ignore_events = nullptr);
+
+  /**
+   * \brief Destroys the SeatManager instance and its seats.
+   */
+  ~SeatManager();
+
+  /**
+   * \brief Registers an observer for new seats.
+   *
+   * \param observer Pointer to the observer.
+   */
+  void register_observer(SeatManagerObserver* observer);
+
+  /**
+   * \brief Unregisters an observer.
+   *
+   * \param observer Pointer to the observer.
+   */
+  void unregister_observer(SeatManagerObserver* observer);
+
+  /**
+   * \brief Enumerates the input devices present and assigns them to seats.
+   *
+   * Call once, after registering observers. Devices plugged in later are
+   * assigned by wait_and_dispatch().
+   */
+  void scan_devices();
+
+  /**
+   * \brief Waits for input on any seat and dispatches it.
+   *
+   * Also handles devices being added and removed.
+   *
+   * \param timeout_ms The maximum time to wait in milliseconds.
+   * \return The number of events handled, or -1 on error.
+   */
+  int wait_and_dispatch(int timeout_ms = -1);
+
+  /**
+   * \brief Gets the epoll file descriptor covering every seat and udev.
+   *
+   * \return The epoll file descriptor.
+   */
+  [[nodiscard]] int get_epoll_fd() const { return epoll_fd_; }
+
+  /**
+   * \brief Gets a seat by ID.
+   *
+   * \param seat_id The ID of the seat.
+   * \return Pointer to the seat, or nullptr if it has no devices yet.
+   */
+  [[nodiscard]] Seat* get_seat(const std::string& seat_id) const;
+
+  /**
+   * \brief Gets the seats by ID.
+   *
+   * \return The seats.
+   */
+  [[nodiscard]] const std::map<std::string, std::unique_ptr<Seat>>& get_seats()
+      const {
+    return seats_;
+  }
+
+  /**
+   * \brief Gets the keymap cache shared by all seats.
+   *
+   * \return A shared pointer to the keymap cache.
+   */
+  [[nodiscard]] const std::shared_ptr<KeymapCache>& get_keymap_cache() const {
+    return keymap_cache_;
+  }
+
+  /**
+   * \brief Maps a seat to the outputs of its station.
+   *
+   * Pointer and touch of the seat are scaled to the first output. The
+   * mapping also applies to a seat created later.
+   *
+   * \param seat_id The ID of the seat.
+   * \param outputs The outputs, owned by their KmsDevice.
+   */
+  void set_seat_outputs(const std::string& seat_id,
+                        std::vector<const Output*> outputs);
+
+  /**
+   * \brief Gets the outputs mapped to a seat.
+   *
+   * \param seat_id The ID of the seat.
+   * \return The outputs, empty if none are mapped.
+   */
+  [[nodiscard]] std::vector<const Output*> get_seat_outputs(
+      const std::string& seat_id) const;
+
+  // Disallow copy and assign.
+  SeatManager(const SeatManager&) = delete;
+
+  SeatManager& operator=(const SeatManager&) = delete;
+
+ private:
+  udev* udev_{};                              /**< udev context */
+  udev_monitor* udev_monitor_{};              /**< Input subsystem monitor */
+  int epoll_fd_ = -1;                         /**< Epoll set of all sources */
+  bool disable_cursor_;                       /**< Whether cursor is disabled */
+  std::string ignore_events_;                 /**< Event mask of every seat */
+  std::shared_ptr<KeymapCache> keymap_cache_; /**< Shared keymap cache */
+
+  std::map<std::string, std::unique_ptr<Seat>> seats_; /**< Seats by ID */
+  std::map<std::string, std::string> device_seats_;    /**< Seat by dev node */
+  std::map<std::string, std::vector<const Output*>>
+      seat_outputs_; /**< Outputs by seat ID */
+
+  utils::ObserverList<SeatManagerObserver> observers_{}; /**< Observers */
+
+  /**
+   * \brief Assigns an added device to its seat, creating the seat if needed.
+   *
+   * \param device The udev device.
+   */
+  void add_device(udev_device* device);
+
+  /**
+   * \brief Removes a device from the seat it was assigned to.
+   *
+   * \param dev_node The device node.
+   */
+  void remove_device(const char* dev_node);
+
+  /**
+   * \brief Handles a pending udev monitor event.
+   */
+  void handle_udev_event();
+
+  /**
+   * \brief Gets a seat, creating and announcing it if needed.
+   *
+   * \param seat_id The ID of the seat.
+   * \return The seat.
+   */
+  Seat& ensure_seat(const std::string& seat_id);
+
+  /**
+   * \brief Applies the output mapping of a seat.
+   *
+   * \param seat The seat.
+   */
+  void apply_outputs(Seat& seat) const;
+};
+}  // namespace drmpp::input
+
+#endif  // INCLUDE_DRMPP_INPUT_SEAT_MANAGER_H_
@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_DRMPP_INPUT_TABLET_H_
+#define INCLUDE_DRMPP_INPUT_TABLET_H_
+
+#include <vector>
+
+#include <libinput.h>
+
+#include "utils/observer_list.h"
+
+namespace drmpp::input {
+class Tablet;
+
+/**
+ * \brief State of a tablet tool after an event.
+ */
+struct TabletToolState {
+  uint64_t time_usec; /**< Event time in microseconds */
+  uint32_t tool_type; /**< libinput_tablet_tool_type */
+  bool in_proximity;  /**< Whether the tool is in proximity */
+  bool tip_down;      /**< Whether the tip touches the surface */
+  double x;           /**< X coordinate in output pixels, or mm */
+  double y;           /**< Y coordinate in output pixels, or mm */
+  double pressure;    /**< Pressure normalized to [0, 1] */
+  double tilt_x;      /**< Tilt along the x axis in degrees */
+  double tilt_y;      /**< Tilt along the y axis in degrees */
+};
+
+/**
+ * \brief Interface for observing tablet tool events.
+ */
+class TabletObserver {
+ public:
+  /**
+   * \brief Virtual destructor for the TabletObserver class.
+   */
+  virtual ~TabletObserver() = default;
+
+  /**
+   * \brief Notify the observer of a tool entering or leaving proximity.
+   *
+   * \param tablet Pointer to the Tablet object.
+   * \param time Event time.
+   * \param state The tool state.
+   */
+  virtual void notify_tablet_tool_proximity(Tablet* tablet,
+                                            uint32_t time,
+                                            const TabletToolState& state) = 0;
+
+  /**
+   * \brief Notify the observer of the tip touching or leaving the surface.
+   *
+   * \param tablet Pointer to the Tablet object.
+   * \param time Event time.
+   * \param state The tool state.
+   */
+  virtual void notify_tablet_tool_tip(Tablet* tablet,
+                                      uint32_t time,
+                                      const TabletToolState& state) = 0;
+
+  /**
+   * \brief Notify the observer of changed tool axes.
+   *
+   * Called once per axis frame, with position, pressure and tilt updated
+   * together.
+   *
+   * \param tablet Pointer to the Tablet object.
+   * \param time Event time.
+   * \param state The tool state.
+   */
+  virtual void notify_tablet_tool_axis(Tablet* tablet,
+                                       uint32_t time,
+                                       const TabletToolState& state) = 0;
+
+  /**
+   * \brief Notify the observer of a tool button event.
+   *
+   * \param tablet Pointer to the Tablet object.
+   * \param time Event time.
+   * \param button The button code.
+   * \param state The button state.
+   */
+  virtual void notify_tablet_tool_button(Tablet* /* tablet */,
+                                         uint32_t /* time */,
+                                         uint32_t /* button */,
+                                         uint32_t /* state */) {}
+};
+
+/**
+ * \brief Class representing the tablet tools of a seat.
+ */
+class Tablet {
+ public:
+  /**
+   * \brief Struct representing the event mask.
+   */
+  struct event_mask {
+    bool enabled; /**< Whether the event mask is enabled */
+    bool all;     /**< Whether all events are masked */
+  };
+
+  /**
+   * \brief Constructs a Tablet instance.
+   *
+   * \param event_mask The initial event mask.
+   */
+  explicit Tablet(event_mask const& event_mask);
+
+  /**
+   * \brief Registers an observer for tablet events.
+   *
+   * \param observer The observer to be registered.
+   * \param user_data User data to be passed to the observer.
+   */
+  void register_observer(TabletObserver* observer, void* user_data = nullptr) {
+    observers_.add(observer);
+
+    if (user_data) {
+      user_data_ = user_data;
+    }
+  }
+
+  /**
+   * \brief Unregisters an observer for tablet events.
+   *
+   * \param observer The observer to be unregistered.
+   */
+  void unregister_observer(TabletObserver* observer) {
+    observers_.remove(observer);
+  }
+
+  /**
+   * \brief Gets the user data.
+   *
+   * \return Pointer to the user data.
+   */
+  [[nodiscard]] void* get_user_data() const { return user_data_; }
+
+  /**
+   * \brief Sets the event mask.
+   *
+   * \param event_mask The event mask to be set.
+   */
+  void set_event_mask(event_mask const& event_mask);
+
+  /**
+   * \brief Sets the output resolution tool positions are mapped to.
+   *
+   * \param width The output width in pixels, or 0 to report mm.
+   * \param height The output height in pixels, or 0 to report mm.
+   */
+  void set_output_size(uint32_t width, uint32_t height);
+
+  /**
+   * \brief Enables or disables per-frame axis coalescing.
+   *
+   * While enabled, axis frames are merged until flush_motion() delivers the
+   * latest state. With history, every merged frame is kept, so high-rate
+   * pens lose no samples while observers run once per render frame.
+   *
+   * \param enable Whether to coalesce axis events.
+   * \param keep_history Whether to keep every merged sample.
+   */
+  void set_motion_coalescing(bool enable, bool keep_history = false);
+
+  /**
+   * \brief Delivers the coalesced axis state.
+   *
+   * Call once per frame when coalescing is enabled. Pending axes are also
+   * flushed before proximity, tip and button events to preserve ordering.
+   */
+  void flush_motion();
+
+  /**
+   * \brief Gets the axis frames merged into the event being delivered.
+   *
+   * Only populated when history is enabled. Valid from within the observer
+   * callbacks of flush_motion().
+   *
+   * \return The full-resolution axis samples.
+   */
+  [[nodiscard]] const std::vector<TabletToolState>& get_axis_history() const {
+    return axis_history_;
+  }
+
+  /**
+   * \brief Gets the current tool state.
+   *
+   * \return The tool state.
+   */
+  [[nodiscard]] const TabletToolState& get_state() const { return state_; }
+
+  /**
+   * \brief Handles a decoded tool proximity event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param tool_type The libinput_tablet_tool_type of the tool.
+   * \param in_proximity Whether the tool entered proximity.
+   * \param x The x-coordinate in mm.
+   * \param y The y-coordinate in mm.
+   * \param nx The x-coordinate normalized to [0, 1].
+   * \param ny The y-coordinate normalized to [0, 1].
+   * \param time_usec The time of the event in microseconds.
+   */
+  void handle_tool_proximity(uint32_t time,
+                             uint32_t tool_type,
+                             bool in_proximity,
+                             double x,
+                             double y,
+                             double nx,
+                             double ny,
+                             uint64_t time_usec);
+
+  /**
+   * \brief Handles a decoded tool tip event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param tip_down Whether the tip touches the surface.
+   * \param x The x-coordinate in mm.
+   * \param y The y-coordinate in mm.
+   * \param nx The x-coordinate normalized to [0, 1].
+   * \param ny The y-coordinate normalized to [0, 1].
+   * \param pressure The pressure normalized to [0, 1].
+   * \param time_usec The time of the event in microseconds.
+   */
+  void handle_tool_tip(uint32_t time,
+                       bool tip_down,
+                       double x,
+                       double y,
+                       double nx,
+                       double ny,
+                       double pressure,
+                       uint64_t time_usec);
+
+  /**
+   * \brief Handles a decoded tool axis frame.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param x The x-coordinate in mm.
+   * \param y The y-coordinate in mm.
+   * \param nx The x-coordinate normalized to [0, 1].
+   * \param ny The y-coordinate normalized to [0, 1].
+   * \param pressure The pressure normalized to [0, 1].
+   * \param tilt_x The tilt along the x axis in degrees.
+   * \param tilt_y The tilt along the y axis in degrees.
+   * \param time_usec The time of the event in microseconds.
+   */
+  void handle_tool_axis(uint32_t time,
+                        double x,
+                        double y,
+                        double nx,
+                        double ny,
+                        double pressure,
+                        double tilt_x,
+                        double tilt_y,
+                        uint64_t time_usec);
+
+  /**
+   * \brief Handles a decoded tool button event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param button The button code.
+   * \param state The button state.
+   */
+  void handle_tool_button(uint32_t time, uint32_t button, uint32_t state);
+
+  // Disallow copy and assign.
+  Tablet(const Tablet&) = delete;
+
+  Tablet& operator=(const Tablet&) = delete;
+
+ private:
+  utils::ObserverList<TabletObserver> observers_{}; /**< Observers */
+  void* user_data_{};                               /**< User data */
+  event_mask event_mask_{};                         /**< Event mask */
+  TabletToolState state_{};                         /**< Current tool state */
+
+  struct {
+    uint32_t width;  /**< Output width in pixels */
+    uint32_t height; /**< Output height in pixels */
+  } output_{};       /**< Output tool positions are mapped to */
+
+  bool coalesce_{};                           /**< Whether axes are coalesced */
+  bool keep_history_{};                       /**< Whether samples are kept */
+  bool axis_pending_{};                       /**< Whether axes are pending */
+  uint32_t axis_time_{};                      /**< Time of the pending axes */
+  std::vector<TabletToolState> axis_history_; /**< Merged axis frames */
+
+  /**
+   * \brief Checks if all tablet events are masked.
+   *
+   * \return True if masked, false otherwise.
+   */
+  [[nodiscard]] bool is_masked() const {
+    return event_mask_.enabled && event_mask_.all;
+  }
+
+  /**
+   * \brief Updates the tool position, mapped to the output if set.
+   *
+   * \param x The x-coordinate in mm.
+   * \param y The y-coordinate in mm.
+   * \param nx The x-coordinate normalized to [0, 1].
+   * \param ny The y-coordinate normalized to [0, 1].
+   */
+  void set_position(double x, double y, double nx, double ny);
+};
+}  // namespace drmpp::input
+
+#endif  // INCLUDE_DRMPP_INPUT_TABLET_H_
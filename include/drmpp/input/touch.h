@@ -17,14 +17,38 @@
 #ifndef INCLUDE_DRMPP_INPUT_TOUCH_H_
 #define INCLUDE_DRMPP_INPUT_TOUCH_H_
 
-#include <list>
-#include <mutex>
+#include <utility>
+#include <vector>
 
 #include <libinput.h>
 
+#include "input/motion_predictor.h"
+#include "utils/observer_list.h"
+
 namespace drmpp::input {
 class Touch;
 
+/**
+ * \brief State of a touch contact within a touch frame.
+ */
+struct TouchContact {
+  /**
+   * \brief Enum representing what happened to a contact in the frame.
+   */
+  enum State {
+    TOUCH_CONTACT_DOWN,       /**< Contact started in this frame */
+    TOUCH_CONTACT_MOTION,     /**< Contact moved in this frame */
+    TOUCH_CONTACT_STATIONARY, /**< Contact did not change in this frame */
+    TOUCH_CONTACT_UP,         /**< Contact ended in this frame */
+  };
+
+  int32_t slot;      /**< Touch slot of the device */
+  int32_t seat_slot; /**< Touch slot of the seat, unique across devices */
+  State state;       /**< State of the contact */
+  double x;          /**< X coordinate in output pixels, or mm */
+  double y;          /**< Y coordinate in output pixels, or mm */
+};
+
 /**
  * \brief Interface for observing touch events.
  */
@@ -67,7 +91,7 @@ class TouchObserver {
    * \param touch Pointer to the Touch object.
    * \param time Event time.
    */
-  virtual void notify_touch_frame(Touch* touch, uint32_t time);
+  virtual void notify_touch_frame(Touch* /* touch */, uint32_t /* time */) {}
 
   /**
    * \brief Notify the observer of a touch cancel event.
@@ -75,7 +99,22 @@ class TouchObserver {
    * \param touch Pointer to the Touch object.
    * \param time Event time.
    */
-  virtual void notify_touch_cancel(Touch* touch, uint32_t time);
+  virtual void notify_touch_cancel(Touch* /* touch */, uint32_t /* time */) {}
+
+  /**
+   * \brief Notify the observer of all contacts of a touch frame.
+   *
+   * Called once per touch frame with every active contact, including the
+   * contacts that ended in the frame.
+   *
+   * \param touch Pointer to the Touch object.
+   * \param time Event time.
+   * \param contacts The contacts of the frame.
+   */
+  virtual void notify_touch_frame_batch(
+      Touch* /* touch */,
+      uint32_t /* time */,
+      const std::vector<TouchContact>& /* contacts */) {}
 
   /**
    * \brief Notify the observer of a touch motion event.
@@ -104,6 +143,17 @@ class Touch {
     bool all;     /**< Whether all events are masked */
   };
 
+  /**
+   * \brief Struct representing a touch motion sample.
+   */
+  struct motion_sample {
+    uint32_t time;     /**< Time of the event */
+    int32_t slot;      /**< Touch slot of the device */
+    int32_t seat_slot; /**< Touch slot of the seat, unique across devices */
+    double x;          /**< X coordinate of the touch */
+    double y;          /**< Y coordinate of the touch */
+  };
+
   /**
    * \brief Default constructor for the Touch class.
    *
@@ -123,7 +173,7 @@ class Touch {
    * \param user_data User data to be passed to the observer.
    */
   void register_observer(TouchObserver* observer, void* user_data = nullptr) {
-    observers_.push_back(observer);
+    observers_.add(observer);
 
     if (user_data) {
       user_data_ = user_data;
@@ -160,6 +210,85 @@ class Touch {
    */
   void set_event_mask(event_mask const& event_mask);
 
+  /**
+   * \brief Sets the output resolution contacts are mapped to.
+   *
+   * \param width The output width in pixels, or 0 to report mm.
+   * \param height The output height in pixels, or 0 to report mm.
+   */
+  void set_output_size(uint32_t width, uint32_t height);
+
+  /**
+   * \brief Enables or disables frame batching.
+   *
+   * While enabled, down, up, motion and frame events are only delivered
+   * through notify_touch_frame_batch(), once per touch frame.
+   *
+   * \param enable Whether to batch touch events per frame.
+   */
+  void set_frame_batching(const bool enable) { batch_frames_ = enable; }
+
+  /**
+   * \brief Enables or disables motion prediction of the contacts.
+   *
+   * \param enable Whether to track contact motion for prediction.
+   * \param params The tuning of the predictors for this device.
+   */
+  void set_prediction(bool enable, const MotionPredictor::params& params = {});
+
+  /**
+   * \brief Predicts the position of a contact at a target time.
+   *
+   * \param seat_slot The touch slot of the seat.
+   * \param target_usec The target time in microseconds, typically from
+   * Output::EstimateNextVblank().
+   * \return The predicted position in the units of the contacts, with a
+   * confidence of 0 if the contact is unknown or prediction is disabled.
+   */
+  [[nodiscard]] MotionPredictor::prediction predict(
+      int32_t seat_slot,
+      uint64_t target_usec) const;
+
+  /**
+   * \brief Gets the contacts of the current touch frame.
+   *
+   * \return The active contacts.
+   */
+  [[nodiscard]] const std::vector<TouchContact>& get_contacts() const {
+    return contacts_;
+  }
+
+  /**
+   * \brief Enables or disables per-frame motion coalescing.
+   *
+   * While enabled, only the last position of each touch slot is kept until
+   * flush_motion() delivers it.
+   *
+   * \param enable Whether to coalesce motion events.
+   * \param keep_history Whether to keep every merged sample.
+   */
+  void set_motion_coalescing(bool enable, bool keep_history = false);
+
+  /**
+   * \brief Delivers the last position of every slot that moved.
+   *
+   * Call once per frame when coalescing is enabled. Pending motion is also
+   * flushed before a down, up or cancel event to preserve ordering.
+   */
+  void flush_motion();
+
+  /**
+   * \brief Gets the samples merged into the events being delivered.
+   *
+   * Only populated when history is enabled. Valid from within the observer
+   * callbacks of flush_motion().
+   *
+   * \return The full-resolution motion samples.
+   */
+  [[nodiscard]] const std::vector<motion_sample>& get_motion_history() const {
+    return motion_history_;
+  }
+
   /**
    * \brief Handles the touch up event.
    *
@@ -195,17 +324,134 @@ class Touch {
    */
   void handle_touch_motion(libinput_event_touch* ev);
 
+  /**
+   * \brief Handles a decoded touch up event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param slot The touch slot of the device.
+   * \param seat_slot The touch slot of the seat.
+   */
+  void handle_touch_up(uint32_t time, int32_t slot, int32_t seat_slot);
+
+  /**
+   * \brief Handles a decoded touch down event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param slot The touch slot of the device.
+   * \param seat_slot The touch slot of the seat.
+   * \param x The x-coordinate in mm.
+   * \param y The y-coordinate in mm.
+   * \param nx The x-coordinate normalized to [0, 1].
+   * \param ny The y-coordinate normalized to [0, 1].
+   * \param time_usec The time of the event in microseconds, or 0.
+   */
+  void handle_touch_down(uint32_t time,
+                         int32_t slot,
+                         int32_t seat_slot,
+                         double x,
+                         double y,
+                         double nx,
+                         double ny,
+                         uint64_t time_usec = 0);
+
+  /**
+   * \brief Handles a decoded touch frame event.
+   *
+   * \param time The time of the event in milliseconds.
+   */
+  void handle_touch_frame(uint32_t time);
+
+  /**
+   * \brief Handles a decoded touch cancel event.
+   *
+   * \param time The time of the event in milliseconds.
+   */
+  void handle_touch_cancel(uint32_t time);
+
+  /**
+   * \brief Handles a decoded touch motion event.
+   *
+   * \param time The time of the event in milliseconds.
+   * \param slot The touch slot of the device.
+   * \param seat_slot The touch slot of the seat.
+   * \param x The x-coordinate in mm.
+   * \param y The y-coordinate in mm.
+   * \param nx The x-coordinate normalized to [0, 1].
+   * \param ny The y-coordinate normalized to [0, 1].
+   * \param time_usec The time of the event in microseconds, or 0.
+   */
+  void handle_touch_motion(uint32_t time,
+                           int32_t slot,
+                           int32_t seat_slot,
+                           double x,
+                           double y,
+                           double nx,
+                           double ny,
+                           uint64_t time_usec = 0);
+
   // Disallow copy and assign.
   Touch(const Touch&) = delete;
 
   Touch& operator=(const Touch&) = delete;
 
  private:
-  std::list<TouchObserver*> observers_{}; /**< List of observers */
-  std::mutex observers_mutex_{};          /**< Mutex for observers list */
-  void* user_data_{};                     /**< User data */
+  utils::ObserverList<TouchObserver> observers_{}; /**< Observers */
+  void* user_data_{};                              /**< User data */
 
   event_mask event_mask_{}; /**< Event mask */
+
+  bool coalesce_{};                             /**< Coalesce motion */
+  bool keep_history_{};                         /**< Keep merged samples */
+  std::vector<motion_sample> pending_motion_{}; /**< Last per seat slot */
+  std::vector<motion_sample> motion_history_{}; /**< Merged samples */
+
+  struct {
+    uint32_t width;  /**< Output width in pixels */
+    uint32_t height; /**< Output height in pixels */
+  } output_{};       /**< Output contacts are mapped to */
+
+  bool batch_frames_{};                  /**< Batch events per frame */
+  std::vector<TouchContact> contacts_{}; /**< Contacts of the frame */
+
+  bool predict_{};                             /**< Whether to predict */
+  MotionPredictor::params predictor_params_{}; /**< Predictor tuning */
+  std::vector<std::pair<int32_t, MotionPredictor>>
+      predictors_{}; /**< Predictors by seat slot */
+
+  /**
+   * \brief Updates the contact of a seat slot.
+   *
+   * \param slot The touch slot of the device.
+   * \param seat_slot The touch slot of the seat.
+   * \param state The new state of the contact.
+   * \param x The x-coordinate in mm.
+   * \param y The y-coordinate in mm.
+   * \param nx The x-coordinate normalized to [0, 1].
+   * \param ny The y-coordinate normalized to [0, 1].
+   * \param time_usec The time of the event in microseconds.
+   */
+  void update_contact(int32_t slot,
+                      int32_t seat_slot,
+                      TouchContact::State state,
+                      double x,
+                      double y,
+                      double nx,
+                      double ny,
+                      uint64_t time_usec);
+
+  /**
+   * \brief Maps a position to the output, if its size is set.
+   *
+   * \param x The x-coordinate in mm.
+   * \param y The y-coordinate in mm.
+   * \param nx The x-coordinate normalized to [0, 1].
+   * \param ny The y-coordinate normalized to [0, 1].
+   * \return The position in output pixels, or in mm.
+   */
+  [[nodiscard]] std::pair<double, double> map_position(double x,
+                                                       double y,
+                                                       double nx,
+                                                       double ny) const;
 };
 }  // namespace drmpp::input
 
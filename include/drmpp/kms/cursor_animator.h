@@ -0,0 +1,82 @@
+#ifndef INCLUDE_DRMPP_KMS_CURSOR_ANIMATOR_H
+#define INCLUDE_DRMPP_KMS_CURSOR_ANIMATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "cursor/xcursor.h"
+#include "kms/cursor_plane.h"
+#include "kms/output.h"
+
+// Plays animated cursors on a CursorPlane using the delay of each frame.
+// Every frame is uploaded once when the cursor is set, a frame change only
+// commits the FB_ID of the cursor plane. Frame changes are driven by a
+// CLOCK_MONOTONIC timerfd that the application polls, aligned to the
+// vblanks of the output when one is given. The timer is disarmed while the
+// cursor is hidden or the pointer is idle.
+class CursorAnimator {
+ public:
+  // Animation pauses after this long without NotifyActivity.
+  static constexpr uint64_t kIdleTimeoutUsec = 30 * 1000000ULL;
+
+  // Frames are committed this long before the vblank that shows them.
+  static constexpr uint64_t kCommitLeadUsec = 2000;
+
+  // output may be nullptr, frames then change at their exact due time.
+  explicit CursorAnimator(CursorPlane* plane, const Output* output = nullptr);
+
+  ~CursorAnimator();
+
+  // Readable when a frame is due, call HandleTimer then.
+  [[nodiscard]] int GetFd() const { return timer_fd_; }
+
+  // Shows a cursor from its first frame, animating it if it has several.
+  bool SetCursor(const std::shared_ptr<drmpp::XCursor::Images>& images);
+
+  // Shows the cursor again after Hide, resuming the animation.
+  bool Show();
+
+  // Hides the cursor and pauses the animation.
+  bool Hide();
+
+  // Call on pointer input. Resumes an animation paused for idleness.
+  void NotifyActivity();
+
+  // Advances to the frame due now and commits it.
+  void HandleTimer();
+
+  [[nodiscard]] bool IsAnimating() const { return armed_; }
+
+  [[nodiscard]] size_t GetFrame() const { return frame_; }
+
+  CursorAnimator(const CursorAnimator&) = delete;
+
+  CursorAnimator& operator=(const CursorAnimator&) = delete;
+
+ private:
+  CursorPlane* plane_;
+  const Output* output_;
+  int timer_fd_;
+
+  std::shared_ptr<drmpp::XCursor::Images> images_;
+  size_t frame_{};
+  // when the current frame is replaced
+  uint64_t due_usec_{};
+  uint64_t last_activity_usec_{};
+  bool armed_{};
+  bool hidden_{};
+
+  [[nodiscard]] bool IsAnimated() const {
+    return images_ && images_->images.size() > 1;
+  }
+
+  [[nodiscard]] uint64_t GetDelayUsec(size_t frame) const;
+
+  // Arms the timer for due_usec_, or the vblank showing it.
+  void Arm(uint64_t now);
+
+  void Disarm();
+};
+
+#endif  // INCLUDE_DRMPP_KMS_CURSOR_ANIMATOR_H
@@ -0,0 +1,175 @@
+#ifndef INCLUDE_DRMPP_KMS_CURSOR_PLANE_H
+#define INCLUDE_DRMPP_KMS_CURSOR_PLANE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+
+#include <xf86drmMode.h>
+
+#include "cursor/xcursor.h"
+#include "plane/plane.h"
+
+class Output;
+
+#ifndef DRM_CLIENT_CAP_CURSOR_PLANE_HOTSPOT
+#define DRM_CLIENT_CAP_CURSOR_PLANE_HOTSPOT 6
+#endif
+
+// Hardware cursor of a CRTC. Uses the atomic cursor plane when the CRTC has
+// one, otherwise the legacy cursor ioctls. Moving the cursor never touches
+// the primary plane.
+class CursorPlane {
+ public:
+  // Cursor buffers kept uploaded. Shapes switched back to are not re-uploaded.
+  static constexpr size_t kPoolCapacity = 16;
+
+  CursorPlane(int drm_fd,
+              uint32_t crtc_id,
+              uint32_t plane_id,
+              uint32_t width,
+              uint32_t height);
+
+  ~CursorPlane();
+
+  // Atomic is opt-in: pass atomic only if the caller enabled
+  // DRM_CLIENT_CAP_ATOMIC on drm_fd, as KmsDevice does, Create never sets it.
+  // Then DRM_CLIENT_CAP_CURSOR_PLANE_HOTSPOT is set where supported and the
+  // cursor plane of the CRTC is used. Otherwise no client cap is changed and
+  // the legacy cursor ioctls are used. Returns nullptr if the CRTC does not
+  // exist.
+  static std::unique_ptr<CursorPlane> Create(int drm_fd,
+                                             uint32_t crtc_id,
+                                             bool atomic = false);
+
+  [[nodiscard]] uint32_t GetCrtcId() const { return crtc_id_; }
+
+  // 0 when the legacy cursor ioctls are used.
+  [[nodiscard]] uint32_t GetPlaneId() const { return plane_id_; }
+
+  [[nodiscard]] bool IsAtomic() const { return plane_id_ != 0; }
+
+  // Whether the hotspot is passed to the driver, as virtualized drivers need.
+  [[nodiscard]] bool HasHotspot() const { return props_.hotspot_x != 0; }
+
+  [[nodiscard]] bool IsVisible() const { return visible_; }
+
+  [[nodiscard]] uint32_t GetWidth() const { return width_; }
+
+  [[nodiscard]] uint32_t GetHeight() const { return height_; }
+
+  // Raises the number of buffers kept, e.g. to hold every frame of an
+  // animated cursor. Never below kPoolCapacity.
+  void SetPoolCapacity(size_t capacity);
+
+  // Uploads a frame of a cursor into the pool unless already there. Images
+  // larger than the plane are cropped, with the hotspot clamped to the crop.
+  bool Upload(const std::shared_ptr<drmpp::XCursor::Images>& images,
+              size_t frame = 0);
+
+  // Shows a frame of a cursor, uploading it first if needed.
+  bool SetCursor(const std::shared_ptr<drmpp::XCursor::Images>& images,
+                 size_t frame = 0);
+
+  // Moves the hotspot of the cursor to x, y on the CRTC. Only the position
+  // is committed, through drmModeMoveCursor where the driver supports it,
+  // otherwise as an atomic CRTC_X/CRTC_Y update. Call at input rate, it does
+  // not wait for the application's next frame. input_time_usec is the
+  // CLOCK_MONOTONIC time of the input, for SetLatencyOutput.
+  bool Move(int32_t x, int32_t y, uint64_t input_time_usec = 0);
+
+  bool Hide();
+
+  // Adds the cursor state to a frame commit about to be made on the CRTC.
+  // Until OnPageFlip, atomic cursor updates are deferred to avoid EBUSY.
+  void AddToRequest(drmModeAtomicReqPtr req);
+
+  // Call from the page flip handler of frames committed on the CRTC.
+  // Commits cursor updates deferred while the frame was in flight.
+  bool OnPageFlip();
+
+  // Atomic cursor commits request a flip event with this plane as user data.
+  // Call from the page flip handler for those events, it commits the cursor
+  // updates deferred while the previous cursor commit was in flight.
+  bool OnCursorFlip(unsigned int sec = 0, unsigned int usec = 0);
+
+  // Measures input-to-scanout latency of cursor commits into the histogram
+  // of output, nullptr to stop. Moves then skip drmModeMoveCursor, which
+  // reports no flip to measure.
+  void SetLatencyOutput(Output* output);
+
+  // Whether cursor state is waiting for OnPageFlip or OnCursorFlip.
+  [[nodiscard]] bool IsDirty() const { return dirty_; }
+
+ private:
+  struct Buffer {
+    std::shared_ptr<drmpp::XCursor::Images> images;  // keeps the key alive
+    size_t frame;
+    int32_t xhot;
+    int32_t yhot;
+    drmpp::plane::Common::dumb_fb fb;
+  };
+
+  int drm_fd_;
+  uint32_t crtc_id_;
+  uint32_t plane_id_;
+  uint32_t width_;
+  uint32_t height_;
+
+  struct {
+    uint32_t fb_id;
+    uint32_t crtc_id;
+    uint32_t src_x;
+    uint32_t src_y;
+    uint32_t src_w;
+    uint32_t src_h;
+    uint32_t crtc_x;
+    uint32_t crtc_y;
+    uint32_t crtc_w;
+    uint32_t crtc_h;
+    uint32_t hotspot_x;
+    uint32_t hotspot_y;
+  } props_{};
+
+  // most recently used first
+  std::list<Buffer> pool_;
+  size_t pool_capacity_{kPoolCapacity};
+  const Buffer* current_{};
+  // last state the driver accepted
+  const Buffer* shown_{};
+  int32_t shown_x_{};
+  int32_t shown_y_{};
+  bool visible_{};
+  int32_t x_{};
+  int32_t y_{};
+
+  // cleared when the legacy ioctl fails, the CRTC has no legacy cursor
+  bool legacy_move_{true};
+  bool frame_pending_{};
+  // a cursor commit awaits its flip event
+  bool cursor_pending_{};
+  Output* latency_output_{};
+  // newest input not yet in a cursor commit
+  uint64_t input_usec_{};
+  bool dirty_{};
+
+  std::list<Buffer>::iterator Find(
+      const std::shared_ptr<drmpp::XCursor::Images>& images,
+      size_t frame);
+
+  void DestroyBuffer(Buffer& buffer) const;
+
+  // Evicts the least recently used buffers over capacity.
+  void Trim();
+
+  void LookupProperties();
+
+  // Adds the state that differs from the shown one and marks it shown.
+  void AddProperties(drmModeAtomicReqPtr req);
+
+  // Non-blocking commits request a flip event, see OnCursorFlip.
+  bool Commit(bool blocking = false);
+};
+
+#endif  // INCLUDE_DRMPP_KMS_CURSOR_PLANE_H
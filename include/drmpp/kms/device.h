@@ -28,6 +28,10 @@ class KmsDevice {
 
   [[nodiscard]] int GetDrmFd() const { return drm_fd_; }
 
+  [[nodiscard]] const std::vector<std::unique_ptr<Output>>& GetOutputs() const {
+    return outputs_;
+  }
+
  private:
   int drm_fd_;
   bool format_modifiers_;
@@ -1,13 +1,20 @@
 #ifndef INCLUDE_DRMPP_KMS_OUTPUT_H
 #define INCLUDE_DRMPP_KMS_OUTPUT_H
 
+#include <deque>
 #include <memory>
 #include <vector>
 
 #include <xf86drmMode.h>
 
+#include "utils/latency_histogram.h"
+
 class Output {
  public:
+  // Frames awaiting OnPageFlip. Beyond it flips were lost or never reported,
+  // and the pending frames are dropped rather than matched to later flips.
+  static constexpr size_t kMaxPendingFrames = 4;
+
   Output(uint32_t plane_id,
          uint32_t crtc_id,
          uint32_t connector_id,
@@ -25,6 +32,46 @@ class Output {
       const std::vector<drmModePlanePtr>& planes,
       const drmModeConnector* connector);
 
+  [[nodiscard]] uint32_t GetCrtcId() const { return crtc_id_; }
+
+  [[nodiscard]] uint32_t GetConnectorId() const { return connector_id_; }
+
+  [[nodiscard]] uint64_t GetRefresh() const { return refresh_; }
+
+  [[nodiscard]] uint32_t GetWidth() const { return mode_.hdisplay; }
+
+  [[nodiscard]] uint32_t GetHeight() const { return mode_.vdisplay; }
+
+  // Records the newest input, as a CLOCK_MONOTONIC libinput time in usec, that
+  // went into the frame just committed. Pass 0 if the frame consumed no input.
+  // Call once per page flip requested, in commit order. The time is that of
+  // drmpp::input::Seat::get_input_token() when the frame was rendered, see
+  // CursorPlane and the drm-snake example.
+  void SubmitFrame(uint64_t input_time_usec);
+
+  // Drops the frame submitted last, call when its commit failed. Its input
+  // is then measured by the next frame submitted.
+  void CancelFrame();
+
+  // Completes the oldest submitted frame from a page flip event and adds its
+  // input-to-scanout latency to the histogram. Requires monotonic DRM
+  // timestamps.
+  void OnPageFlip(unsigned int sec, unsigned int usec);
+
+  [[nodiscard]] const drmpp::utils::LatencyHistogram& GetLatencyHistogram()
+      const {
+    return latency_;
+  }
+
+  void ResetLatency();
+
+  // Estimates the first vblank at or after now_usec (CLOCK_MONOTONIC) from the
+  // last page flip and the refresh rate. Returns now_usec if no page flip was
+  // seen yet. Use it as the target time for input motion prediction.
+  [[nodiscard]] uint64_t EstimateNextVblank(uint64_t now_usec) const;
+
+  void LogLatency() const;
+
  private:
   uint32_t plane_id_;
   uint32_t crtc_id_;
@@ -34,6 +81,11 @@ class Output {
   uint64_t refresh_;
   bool needs_repaint_;
   int commit_fence_fd_;
+
+  std::deque<uint64_t> pending_input_usec_;
+  uint64_t last_input_usec_{};
+  uint64_t last_flip_usec_{};
+  drmpp::utils::LatencyHistogram latency_;
 };
 
 #endif  // INCLUDE_DRMPP_KMS_OUTPUT_H
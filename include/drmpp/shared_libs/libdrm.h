@@ -156,6 +156,22 @@ struct LibDrmExports {
                               uint32_t bo_handle,
                               uint32_t* buf_id);
 
+  typedef int (*DrmModeSetCursor2)(int fd,
+                                   uint32_t crtcId,
+                                   uint32_t bo_handle,
+                                   uint32_t width,
+                                   uint32_t height,
+                                   int32_t hot_x,
+                                   int32_t hot_y);
+
+  typedef int (*DrmModeMoveCursor)(int fd, uint32_t crtcId, int x, int y);
+
+  typedef int (*DrmModePageFlip)(int fd,
+                                 uint32_t crtc_id,
+                                 uint32_t fb_id,
+                                 uint32_t flags,
+                                 void* user_data);
+
   typedef int (*DrmSetClientCap)(int fd, uint64_t capability, uint64_t value);
 
   typedef int (*DrmGetCap)(int fd, uint64_t capability, uint64_t* value);
@@ -215,6 +231,9 @@ struct LibDrmExports {
   DrmModeGetPlane ModeGetPlane = nullptr;
   DrmModeFreePlane ModeFreePlane = nullptr;
   DrmModeRmFB ModeRmFB = nullptr;
+  DrmModeSetCursor2 ModeSetCursor2 = nullptr;
+  DrmModeMoveCursor ModeMoveCursor = nullptr;
+  DrmModePageFlip ModePageFlip = nullptr;
 
   DrmGetVersion GetVersion = nullptr;
   DrmFreeVersion FreeVersion = nullptr;
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_DRMPP_UTILS_LATENCY_HISTOGRAM_H_
+#define INCLUDE_DRMPP_UTILS_LATENCY_HISTOGRAM_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace drmpp::utils {
+/**
+ * \brief Fixed-bucket histogram of latencies in microseconds.
+ *
+ * Samples are counted in kBucketUsec wide buckets up to kMaxUsec, with a
+ * final bucket for everything above. Adding a sample never allocates, so it
+ * can be used from a page flip handler.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr uint64_t kBucketUsec = 250;
+  static constexpr uint64_t kMaxUsec = 200000;
+  static constexpr size_t kBuckets = kMaxUsec / kBucketUsec + 1;
+
+  /**
+   * \brief Adds a sample.
+   *
+   * \param usec The latency in microseconds.
+   */
+  void add(const uint64_t usec) {
+    buckets_[std::min<uint64_t>(usec / kBucketUsec, kBuckets - 1)]++;
+    if (count_ == 0 || usec < min_) {
+      min_ = usec;
+    }
+    max_ = std::max(max_, usec);
+    sum_ += usec;
+    count_++;
+  }
+
+  /**
+   * \brief Removes all samples.
+   */
+  void reset() { *this = {}; }
+
+  /**
+   * \brief Gets the latency below which a percentage of samples fall.
+   *
+   * The result is the upper bound of the bucket holding the percentile, and
+   * is clamped to the largest sample.
+   *
+   * \param percentile The percentile in the range [0, 100].
+   * \return The latency in microseconds, or 0 if there are no samples.
+   */
+  [[nodiscard]] uint64_t percentile(const double percentile) const {
+    if (count_ == 0) {
+      return 0;
+    }
+    const auto p = std::clamp(percentile, 0.0, 100.0);
+    const auto rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(p / 100.0 * static_cast<double>(count_) +
+                                 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+      seen += buckets_[i];
+      if (seen >= rank) {
+        return std::min((i + 1) * kBucketUsec, max_);
+      }
+    }
+    return max_;
+  }
+
+  /**
+   * \brief Gets the number of samples.
+   *
+   * \return The number of samples.
+   */
+  [[nodiscard]] uint64_t count() const { return count_; }
+
+  /**
+   * \brief Gets the smallest sample.
+   *
+   * \return The latency in microseconds.
+   */
+  [[nodiscard]] uint64_t min() const { return min_; }
+
+  /**
+   * \brief Gets the largest sample.
+   *
+   * \return The latency in microseconds.
+   */
+  [[nodiscard]] uint64_t max() const { return max_; }
+
+  /**
+   * \brief Gets the mean of the samples.
+   *
+   * \return The latency in microseconds, or 0 if there are no samples.
+   */
+  [[nodiscard]] uint64_t mean() const { return count_ ? sum_ / count_ : 0; }
+
+  /**
+   * \brief Gets the bucket counts.
+   *
+   * \return The bucket counts.
+   */
+  [[nodiscard]] const std::array<uint32_t, kBuckets>& buckets() const {
+    return buckets_;
+  }
+
+ private:
+  std::array<uint32_t, kBuckets> buckets_{}; /**< Samples per bucket */
+  uint64_t count_{};                         /**< Number of samples */
+  uint64_t min_{};                           /**< Smallest sample */
+  uint64_t max_{};                           /**< Largest sample */
+  uint64_t sum_{};                           /**< Sum of the samples */
+};
+}  // namespace drmpp::utils
+
+#endif  // INCLUDE_DRMPP_UTILS_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_DRMPP_UTILS_OBSERVER_LIST_H_
+#define INCLUDE_DRMPP_UTILS_OBSERVER_LIST_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace drmpp::utils {
+/**
+ * \brief Copy-on-write list of observers with lock-free dispatch.
+ *
+ * Writers (add/remove) are serialized by a mutex and publish a new immutable
+ * array through an atomic pointer. Readers (for_each) only increment a reader
+ * count and load the pointer, so dispatching an event never takes a lock.
+ *
+ * Replaced arrays are retired and freed once no readers are in flight, by
+ * the writer or by the last reader to leave, or on destruction. Observers may
+ * add or remove observers from within a callback.
+ *
+ * Each dispatch costs two sequentially consistent RMWs on the shared reader
+ * count, the same as an uncontended mutex, and the count's cache line moves
+ * between threads that dispatch concurrently. Seats dispatch from a single
+ * thread, where this stays cheap; per-thread epochs would avoid the sharing
+ * but need threads to register with each list.
+ *
+ * \tparam T The observer type.
+ */
+template <typename T>
+class ObserverList {
+ public:
+  ObserverList() = default;
+
+  ~ObserverList() {
+    delete current_.load();
+    for (const auto list : retired_) {
+      delete list;
+    }
+  }
+
+  /**
+   * \brief Adds an observer.
+   *
+   * Adding an observer that is already registered has no effect, so
+   * observers may register again when capabilities are re-announced.
+   *
+   * \param observer Pointer to the observer.
+   */
+  void add(T* observer) {
+    std::scoped_lock lock(mutex_);
+    const auto old_list = current_.load();
+    if (old_list && std::find(old_list->begin(), old_list->end(), observer) !=
+                        old_list->end()) {
+      return;
+    }
+    auto list = old_list ? new std::vector<T*>(*old_list)
+                         : new std::vector<T*>();
+    list->push_back(observer);
+    publish(list, old_list);
+  }
+
+  /**
+   * \brief Removes all occurrences of an observer.
+   *
+   * \param observer Pointer to the observer.
+   */
+  void remove(T* observer) {
+    std::scoped_lock lock(mutex_);
+    const auto old_list = current_.load();
+    if (!old_list) {
+      return;
+    }
+    auto list = new std::vector<T*>(*old_list);
+    list->erase(std::remove(list->begin(), list->end(), observer),
+                list->end());
+    publish(list, old_list);
+  }
+
+  /**
+   * \brief Checks if no observers are registered.
+   *
+   * \return True if the list is empty, false otherwise.
+   */
+  [[nodiscard]] bool empty() const {
+    const auto list = current_.load();
+    return !list || list->empty();
+  }
+
+  /**
+   * \brief Invokes a function for each registered observer.
+   *
+   * \param fn The function to invoke with each observer.
+   */
+  template <typename Fn>
+  void for_each(Fn&& fn) const {
+    readers_.fetch_add(1);
+    if (const auto list = current_.load()) {
+      for (const auto observer : *list) {
+        fn(observer);
+      }
+    }
+    // the last reader frees arrays retired while it ran, unless a writer is
+    // busy and will do so itself
+    if (readers_.fetch_sub(1) == 1 && has_retired_.load()) {
+      if (std::unique_lock lock(mutex_, std::try_to_lock); lock) {
+        reclaim();
+      }
+    }
+  }
+
+  // Disallow copy and assign.
+  ObserverList(const ObserverList&) = delete;
+
+  ObserverList& operator=(const ObserverList&) = delete;
+
+ private:
+  std::atomic<const std::vector<T*>*> current_{}; /**< Published array */
+  mutable std::atomic<uint32_t> readers_{};       /**< Dispatches in flight */
+  mutable std::vector<const std::vector<T*>*> retired_{}; /**< Replaced */
+  mutable std::atomic<bool> has_retired_{}; /**< Whether retired_ is used */
+  mutable std::mutex mutex_{};              /**< Serializes writers */
+
+  /**
+   * \brief Publishes a new array and retires the previous one.
+   *
+   * Must be called with mutex_ held. The reader count is checked after the
+   * new array is published, so a reader that is not counted can only observe
+   * the new array.
+   *
+   * \param list The new array.
+   * \param old_list The array being replaced.
+   */
+  void publish(const std::vector<T*>* list, const std::vector<T*>* old_list) {
+    current_.store(list);
+    if (old_list) {
+      retired_.push_back(old_list);
+      has_retired_.store(true);
+    }
+    reclaim();
+  }
+
+  /**
+   * \brief Frees the retired arrays if no readers are in flight.
+   *
+   * Must be called with mutex_ held. Retired arrays are no longer published,
+   * so a reader counted after the check cannot observe them.
+   */
+  void reclaim() const {
+    if (retired_.empty() || readers_.load() != 0) {
+      return;
+    }
+    for (const auto retired : retired_) {
+      delete retired;
+    }
+    retired_.clear();
+    has_retired_.store(false);
+  }
+};
+}  // namespace drmpp::utils
+
+#endif  // INCLUDE_DRMPP_UTILS_OBSERVER_LIST_H_
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_DRMPP_UTILS_SPSC_RING_H_
+#define INCLUDE_DRMPP_UTILS_SPSC_RING_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace drmpp::utils {
+/**
+ * \brief Bounded lock-free ring for one producer and one consumer thread.
+ *
+ * The producer only writes the tail and the consumer only writes the head,
+ * each on its own cache line, so neither side ever blocks the other.
+ *
+ * \tparam T The element type, which must be trivially copyable.
+ * \tparam N The capacity, which must be a power of two.
+ */
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(std::is_trivially_copyable_v<T>);
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+ public:
+  /**
+   * \brief Pushes an element. Producer thread only.
+   *
+   * \param value The element to push.
+   * \return True on success, false if the ring is full.
+   */
+  bool push(const T& value) {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ == N) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ == N) {
+        return false;
+      }
+    }
+    slots_[tail & (N - 1)] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * \brief Pops an element. Consumer thread only.
+   *
+   * \param value Receives the popped element.
+   * \return True on success, false if the ring is empty.
+   */
+  bool pop(T& value) {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) {
+        return false;
+      }
+    }
+    value = slots_[head & (N - 1)];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * \brief Gets the number of queued elements.
+   *
+   * The result is only a snapshot when called concurrently.
+   *
+   * \return The number of queued elements.
+   */
+  [[nodiscard]] size_t size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * \brief Gets the capacity of the ring.
+   *
+   * \return The capacity.
+   */
+  static constexpr size_t capacity() { return N; }
+
+ private:
+  static constexpr size_t kCacheLine = 64;
+
+  alignas(kCacheLine) std::atomic<size_t> head_{}; /**< Next slot to pop */
+  size_t tail_cache_{}; /**< Consumer copy of tail_ */
+  alignas(kCacheLine) std::atomic<size_t> tail_{}; /**< Next slot to push */
+  size_t head_cache_{}; /**< Producer copy of head_ */
+  alignas(kCacheLine) std::array<T, N> slots_{}; /**< Elements */
+};
+}  // namespace drmpp::utils
+
+#endif  // INCLUDE_DRMPP_UTILS_SPSC_RING_H_
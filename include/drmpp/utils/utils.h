@@ -19,7 +19,10 @@
 
 #include <algorithm>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <cctype>
@@ -94,6 +97,61 @@ inline std::string& ltrim(std::string& s, const char* t) {
   return result;
 }
 
+/**
+ * \brief Reads a key from an ini style file such as index.theme.
+ *
+ * Groups are not tracked; the keys looked up are unique in the files read.
+ *
+ * \param path The file to read.
+ * \param key The key to look up.
+ * \return The value, or an empty string if not present.
+ */
+[[maybe_unused]] inline std::string read_ini_value(
+    const std::filesystem::path& path,
+    const std::string_view key) {
+  std::ifstream file(path);
+  if (!file) {
+    return {};
+  }
+  std::string line;
+  while (std::getline(file, line)) {
+    ltrim(line, " \t");
+    if (line.compare(0, key.size(), key) != 0) {
+      continue;
+    }
+    const auto pos = line.find_first_not_of(" \t", key.size());
+    if (pos == std::string::npos || line[pos] != '=') {
+      continue;
+    }
+    auto value = line.substr(pos + 1);
+    return trim(value, " \t\r\"");
+  }
+  return {};
+}
+
+/**
+ * \brief Reads a list separated by commas or semicolons, such as Inherits,
+ * from an ini style file.
+ *
+ * \param path The file to read.
+ * \param key The key to look up.
+ * \return The non-empty entries in order, or an empty vector if not present.
+ */
+[[maybe_unused]] inline std::vector<std::string> read_ini_list(
+    const std::filesystem::path& path,
+    const std::string_view key) {
+  auto value = read_ini_value(path, key);
+  std::replace(value.begin(), value.end(), ';', ',');
+  std::vector<std::string> result;
+  for (auto& entry : split(value, ",")) {
+    trim(entry, " \t\"");
+    if (!entry.empty()) {
+      result.push_back(std::move(entry));
+    }
+  }
+  return result;
+}
+
 /**
  * \brief Checks if the character `c` is a safe character.
  *
@@ -542,66 +600,107 @@ std::ostream& operator<<(std::ostream& out,
  * \brief Decompresses LZ compressed data.
  *
  * This function decompresses data that has been compressed using a simple LZ
- * (Lempel-Ziv) compression algorithm. It handles literal runs, short matches,
- * and long matches to reconstruct the original uncompressed data.
+ * (Lempel-Ziv) compression algorithm, the FastLZ level 1 format. It handles
+ * literal runs, short matches, and long matches to reconstruct the original
+ * uncompressed data.
+ *
+ * Every run and match is checked against both buffers before it is copied.
+ * Away from the end of the output, literal runs are copied with one fixed
+ * size memcpy and matches in 8 byte words. A match word never overlaps its
+ * source once the match distance is 8 or more, so overlapping matches take
+ * the same path and repeat their pattern. Shorter distances are copied byte
+ * by byte, or with memset for a run of one byte.
  *
  * \param data The compressed data to be decompressed.
  * \param compressed_size The size of the compressed data.
  * \param uncompressed_size The expected size of the uncompressed data.
- * \return A vector containing the decompressed data.
+ * \return A vector containing the decompressed data, or an empty vector if
+ * the data is corrupt.
  */
 inline std::vector<uint8_t> decompress_lz_asset(
     const uint8_t data[],
     const size_t compressed_size,
     const size_t uncompressed_size) {
-  int src = 0;
-  int dest = 0;
+  // longest literal run, copied at once when both buffers have room
+  constexpr size_t kMaxLiteral = 32;
+  constexpr size_t kWord = 8;
 
-  const uint8_t* input = data;
-  const int length = compressed_size;
-  std::vector<uint8_t> buffer(uncompressed_size, 0);
+  std::vector<uint8_t> buffer(uncompressed_size);
 
-  uint8_t* output = buffer.data();
+  const uint8_t* ip = data;
+  const uint8_t* const ip_end = data + compressed_size;
+  uint8_t* const output = buffer.data();
+  uint8_t* op = output;
+  uint8_t* const op_end = output + uncompressed_size;
+  bool corrupt = false;
 
-  while (src < length) {
-    if (const int type = input[src] >> 5; type == 0) {
+  while (ip < ip_end) {
+    const uint32_t ctrl = *ip++;
+    const uint32_t type = ctrl >> 5;
+    const auto out_left = static_cast<size_t>(op_end - op);
+
+    if (type == 0) {
       // literal run
-      int run = 1 + input[src];
-      src = src + 1;
-      while (run > 0) {
-        output[dest] = input[src];
-        src = src + 1;
-        dest = dest + 1;
-        run = run - 1;
+      const size_t run = 1 + ctrl;
+      const auto in_left = static_cast<size_t>(ip_end - ip);
+      if (run > in_left || run > out_left) {
+        corrupt = true;
+        break;
+      }
+      if (in_left >= kMaxLiteral && out_left >= kMaxLiteral) {
+        std::memcpy(op, ip, kMaxLiteral);
+      } else {
+        std::memcpy(op, ip, run);
+      }
+      ip += run;
+      op += run;
+      continue;
+    }
+
+    // short match, or long match with an extra length byte
+    size_t len = 2 + type;
+    if (type == 7) {
+      if (ip == ip_end) {
+        corrupt = true;
+        break;
       }
-    } else if (type < 7) {
-      // short match
-      const int ofs = 256 * (input[src] & 31) + input[src + 1];
-      int len = 2 + (input[src] >> 5);
-      src = src + 2;
-      int ref = dest - ofs - 1;
-      while (len > 0) {
-        output[dest] = output[ref];
-        ref = ref + 1;
-        dest = dest + 1;
-        len = len - 1;
+      len += *ip++;
+    }
+    if (ip == ip_end) {
+      corrupt = true;
+      break;
+    }
+    const size_t distance = ((ctrl & 31) << 8 | *ip++) + 1;
+    if (distance > static_cast<size_t>(op - output) || len > out_left) {
+      corrupt = true;
+      break;
+    }
+
+    const uint8_t* ref = op - distance;
+    if (distance >= kWord && out_left - len >= kWord - 1) {
+      // may write up to 7 bytes past the match, overwritten later
+      for (size_t i = 0; i < len; i += kWord) {
+        std::memcpy(op + i, ref + i, kWord);
       }
+    } else if (distance >= len) {
+      std::memcpy(op, ref, len);
+    } else if (distance == 1) {
+      std::memset(op, *ref, len);
     } else {
-      // long match
-      const int ofs = 256 * (input[src] & 31) + input[src + 2];
-      int len = 9 + input[src + 1];
-      src = src + 3;
-      int ref = dest - ofs - 1;
-      while (len > 0) {
-        output[dest] = output[ref];
-        ref = ref + 1;
-        dest = dest + 1;
-        len = len - 1;
+      for (size_t i = 0; i < len; i++) {
+        op[i] = ref[i];
       }
     }
+    op += len;
+  }
+
+  if (corrupt || op != op_end) {
+    LOG_ERROR("lz asset corrupt at input {}, output {}", ip - data,
+              op - output);
+    return {};
   }
-  assert(static_cast<int>(uncompressed_size) == dest);
-  LOG_INFO("lz asset compressed: {}, decompressed: {}", compressed_size, dest);
+  LOG_INFO("lz asset compressed: {}, decompressed: {}", compressed_size,
+           uncompressed_size);
   return buffer;
 }
 }  // namespace drmpp::utils
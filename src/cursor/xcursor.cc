@@ -27,12 +27,17 @@
 #include "cursor/xcursor.h"
 
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
-#include <iostream>
 #include <memory>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace drmpp {
 static constexpr uint32_t kMagic = 0x72756358;  // "Xcur" LSBFirst
 static constexpr uint32_t kFileMajor = 1;
@@ -86,66 +91,52 @@ void XCursor::destroy_images(std::unique_ptr<Images>& images) {
   images.reset();
 }
 
-bool XCursor::read_uint(std::ifstream& file, uint32_t& u) {
-  if (unsigned char bytes[4]; file.read(reinterpret_cast<char*>(bytes), 4)) {
-    u = static_cast<uint32_t>(bytes[0]) << 0 |
-        static_cast<uint32_t>(bytes[1]) << 8 |
-        static_cast<uint32_t>(bytes[2]) << 16 |
-        static_cast<uint32_t>(bytes[3]) << 24;
-    return true;
+/// reads a little-endian value, the caller has checked the bounds
+static uint32_t load_le32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) << 0 | static_cast<uint32_t>(p[1]) << 8 |
+         static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+/// copies little-endian pixels into host order
+static void copy_le32(uint32_t* dst, const uint8_t* src, const size_t count) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  std::memcpy(dst, src, count * sizeof(uint32_t));
+#else
+  for (size_t i = 0; i < count; i++) {
+    dst[i] = load_le32(src + i * sizeof(uint32_t));
   }
-  return false;
+#endif
 }
 
 std::unique_ptr<XCursor::FileHeader> XCursor::read_file_header(
-    std::ifstream& file) {
-  FileHeader head(0);
-  if (!read_uint(file, head.magic) || head.magic != kMagic ||
-      !read_uint(file, head.header) || !read_uint(file, head.version) ||
-      !read_uint(file, head.num_toc)) {
+    const uint8_t* data,
+    const size_t length) {
+  if (length < kFileHeaderLength || load_le32(data) != kMagic) {
     return nullptr;
   }
+  const uint32_t header = load_le32(data + 4);
+  const uint32_t num_toc = load_le32(data + 12);
 
-  if (const uint32_t skip = head.header - kFileHeaderLength;
-      skip && !file.seekg(skip, std::ios::cur)) {
+  // the table of contents follows the header, 3 values per entry
+  constexpr size_t kTocLength = 3 * sizeof(uint32_t);
+  if (header < kFileHeaderLength || header > length ||
+      num_toc > (length - header) / kTocLength) {
     return nullptr;
   }
 
-  auto file_header = std::make_unique<FileHeader>(head.num_toc);
-  file_header->magic = head.magic;
-  file_header->header = head.header;
-  file_header->version = head.version;
-  file_header->num_toc = head.num_toc;
-
-  for (uint32_t n = 0; n < file_header->num_toc; ++n) {
-    if (!read_uint(file, file_header->toc[n].type) ||
-        !read_uint(file, file_header->toc[n].subtype) ||
-        !read_uint(file, file_header->toc[n].position)) {
-      return nullptr;
-    }
-  }
-  return file_header;
-}
+  auto file_header = std::make_unique<FileHeader>(num_toc);
+  file_header->magic = kMagic;
+  file_header->header = header;
+  file_header->version = load_le32(data + 8);
 
-bool XCursor::seek_to_toc(std::ifstream& file,
-                          const FileHeader& file_header,
-                          const int toc) {
-  return file.seekg(file_header.toc[toc].position, std::ios::beg).good();
-}
-
-bool XCursor::read_chunk_header(std::ifstream& file,
-                                const FileHeader& file_header,
-                                const int toc,
-                                ChunkHeader& chunk_header) {
-  if (!seek_to_toc(file, file_header, toc) ||
-      !read_uint(file, chunk_header.header) ||
-      !read_uint(file, chunk_header.type) ||
-      !read_uint(file, chunk_header.subtype) ||
-      !read_uint(file, chunk_header.version)) {
-    return false;
+  const uint8_t* p = data + header;
+  for (auto& toc : file_header->toc) {
+    toc.type = load_le32(p);
+    toc.subtype = load_le32(p + 4);
+    toc.position = load_le32(p + 8);
+    p += kTocLength;
   }
-  return chunk_header.type == file_header.toc[toc].type &&
-         chunk_header.subtype == file_header.toc[toc].subtype;
+  return file_header;
 }
 
 uint32_t XCursor::dist(const uint32_t a, const uint32_t b) {
@@ -188,25 +179,47 @@ int XCursor::find_image_toc(const FileHeader& file_header,
 }
 
 std::unique_ptr<XCursor::Image> XCursor::read_image(
-    std::ifstream& file,
+    const uint8_t* data,
+    const size_t length,
     const FileHeader& file_header,
     const int toc) {
-  ChunkHeader chunk_header{};
-  ImageHeader head{};
+  // chunk header and image header, 4 and 5 values
+  constexpr size_t kHeadersLength = 9 * sizeof(uint32_t);
+  const auto& entry = file_header.toc[toc];
+  if (entry.position > length || length - entry.position < kHeadersLength) {
+    return nullptr;
+  }
+  const uint8_t* p = data + entry.position;
 
-  if (!read_chunk_header(file, file_header, toc, chunk_header) ||
-      !read_uint(file, head.width) || !read_uint(file, head.height) ||
-      !read_uint(file, head.x_hot) || !read_uint(file, head.y_hot) ||
-      !read_uint(file, head.delay)) {
+  ChunkHeader chunk_header{};
+  chunk_header.header = load_le32(p);
+  chunk_header.type = load_le32(p + 4);
+  chunk_header.subtype = load_le32(p + 8);
+  chunk_header.version = load_le32(p + 12);
+  if (chunk_header.type != entry.type ||
+      chunk_header.subtype != entry.subtype) {
     return nullptr;
   }
 
+  ImageHeader head{};
+  head.width = load_le32(p + 16);
+  head.height = load_le32(p + 20);
+  head.x_hot = load_le32(p + 24);
+  head.y_hot = load_le32(p + 28);
+  head.delay = load_le32(p + 32);
+
   if (head.width > kMaxCursorSize || head.height > kMaxCursorSize ||
       head.width == 0 || head.height == 0 || head.x_hot > head.width ||
       head.y_hot > head.height) {
     return nullptr;
   }
 
+  // at most 0x7fff * 0x7fff * 4 bytes, which fits a 32-bit size_t
+  const size_t count = static_cast<size_t>(head.width) * head.height;
+  if (length - entry.position - kHeadersLength < count * sizeof(uint32_t)) {
+    return nullptr;
+  }
+
   auto image =
       create_image(static_cast<int>(head.width), static_cast<int>(head.height));
   if (!image) {
@@ -223,25 +236,20 @@ std::unique_ptr<XCursor::Image> XCursor::read_image(
   image->yhot = head.y_hot;
   image->delay = head.delay;
 
-  for (uint32_t& pixel : image->pixels) {
-    if (!read_uint(file, pixel)) {
-      destroy_image(image);
-      return nullptr;
-    }
-  }
+  copy_le32(image->pixels.data(), p + kHeadersLength, count);
   return image;
 }
 
-std::unique_ptr<XCursor::Images> XCursor::load_images(std::ifstream& file,
-                                                      const int size) {
-  const auto file_header = read_file_header(file);
+std::unique_ptr<XCursor::Images> XCursor::load_images(const uint8_t* data,
+                                                      const size_t length,
+                                                      const uint32_t size) {
+  const auto file_header = read_file_header(data, length);
   if (!file_header) {
     return nullptr;
   }
 
   size_t n_size;
-  const uint32_t best_size_ =
-      best_size(*file_header, static_cast<uint32_t>(size), n_size);
+  const uint32_t best_size_ = best_size(*file_header, size, n_size);
   if (!best_size_) {
     return nullptr;
   }
@@ -250,6 +258,7 @@ std::unique_ptr<XCursor::Images> XCursor::load_images(std::ifstream& file,
   if (!images) {
     return nullptr;
   }
+  images->size = best_size_;
 
   for (size_t n = 0; n < n_size; ++n) {
     const int toc = find_image_toc(*file_header, best_size_, n);
@@ -257,10 +266,11 @@ std::unique_ptr<XCursor::Images> XCursor::load_images(std::ifstream& file,
       break;
     }
 
-    images->images.emplace_back(read_image(file, *file_header, toc));
-    if (!images->images[n]) {
+    auto image = read_image(data, length, *file_header, toc);
+    if (!image) {
       break;
     }
+    images->images.emplace_back(std::move(image));
   }
 
   if (images->images.size() != n_size) {
@@ -270,150 +280,50 @@ std::unique_ptr<XCursor::Images> XCursor::load_images(std::ifstream& file,
   return images;
 }
 
-bool XCursor::read_uint(std::istream& file, uint32_t& u) {
-  if (unsigned char bytes[4]; file.read(reinterpret_cast<char*>(bytes), 4)) {
-    u = static_cast<uint32_t>(bytes[0]) << 0 |
-        static_cast<uint32_t>(bytes[1]) << 8 |
-        static_cast<uint32_t>(bytes[2]) << 16 |
-        static_cast<uint32_t>(bytes[3]) << 24;
-    return true;
-  }
-  return false;
-}
-
-std::unique_ptr<XCursor::FileHeader> XCursor::read_file_header(
-    std::istream& file) {
-  FileHeader head(0);
-  if (!read_uint(file, head.magic) || head.magic != kMagic ||
-      !read_uint(file, head.header) || !read_uint(file, head.version) ||
-      !read_uint(file, head.num_toc)) {
-    return nullptr;
-  }
-
-  if (const uint32_t skip = head.header - kFileHeaderLength;
-      skip && !file.seekg(skip, std::ios::cur)) {
-    return nullptr;
-  }
-
-  auto file_header = std::make_unique<FileHeader>(head.num_toc);
-  file_header->magic = head.magic;
-  file_header->header = head.header;
-  file_header->version = head.version;
-  file_header->num_toc = head.num_toc;
-
-  for (uint32_t n = 0; n < file_header->num_toc; ++n) {
-    if (!read_uint(file, file_header->toc[n].type) ||
-        !read_uint(file, file_header->toc[n].subtype) ||
-        !read_uint(file, file_header->toc[n].position)) {
-      return nullptr;
-    }
-  }
-  return file_header;
-}
-
-bool XCursor::seek_to_toc(std::istream& file,
-                          const FileHeader& file_header,
-                          const int toc) {
-  return file.seekg(file_header.toc[toc].position, std::ios::beg).good();
-}
-
-bool XCursor::read_chunk_header(std::istream& file,
-                                const FileHeader& file_header,
-                                const int toc,
-                                ChunkHeader& chunk_header) {
-  if (!seek_to_toc(file, file_header, toc) ||
-      !read_uint(file, chunk_header.header) ||
-      !read_uint(file, chunk_header.type) ||
-      !read_uint(file, chunk_header.subtype) ||
-      !read_uint(file, chunk_header.version)) {
-    return false;
-  }
-  return chunk_header.type == file_header.toc[toc].type &&
-         chunk_header.subtype == file_header.toc[toc].subtype;
+std::unique_ptr<XCursor::Images> XCursor::load_images(
+    const std::vector<uint8_t>& buffer,
+    const uint32_t size) {
+  return load_images(buffer.data(), buffer.size(), size);
 }
 
-std::unique_ptr<XCursor::Image> XCursor::read_image(
-    std::istream& file,
-    const FileHeader& file_header,
-    const int toc) {
-  ChunkHeader chunk_header{};
-  ImageHeader head{};
-
-  if (!read_chunk_header(file, file_header, toc, chunk_header) ||
-      !read_uint(file, head.width) || !read_uint(file, head.height) ||
-      !read_uint(file, head.x_hot) || !read_uint(file, head.y_hot) ||
-      !read_uint(file, head.delay)) {
+std::unique_ptr<XCursor::Images> XCursor::load_images(std::ifstream& file,
+                                                      const int size) {
+  const auto begin = file.tellg();
+  if (begin < 0 || !file.seekg(0, std::ios::end)) {
     return nullptr;
   }
-
-  if (head.width > kMaxCursorSize || head.height > kMaxCursorSize ||
-      head.width == 0 || head.height == 0 || head.x_hot > head.width ||
-      head.y_hot > head.height) {
+  const auto end = file.tellg();
+  if (end < begin || !file.seekg(begin)) {
     return nullptr;
   }
-
-  auto image =
-      create_image(static_cast<int>(head.width), static_cast<int>(head.height));
-  if (!image) {
+  std::vector<uint8_t> buffer(static_cast<size_t>(end - begin));
+  if (!file.read(reinterpret_cast<char*>(buffer.data()),
+                 static_cast<std::streamsize>(buffer.size()))) {
     return nullptr;
   }
-
-  if (chunk_header.version < image->version) {
-    image->version = chunk_header.version;
-  }
-
-  image->width = head.width;
-  image->height = head.height;
-  image->xhot = head.x_hot;
-  image->yhot = head.y_hot;
-  image->delay = head.delay;
-
-  for (uint32_t& pixel : image->pixels) {
-    if (!read_uint(file, pixel)) {
-      destroy_image(image);
-      return nullptr;
-    }
-  }
-  return image;
+  return load_images(buffer, static_cast<uint32_t>(size));
 }
 
-std::unique_ptr<XCursor::Images> XCursor::load_images(
-    const std::vector<uint8_t>& buffer,
+std::unique_ptr<XCursor::Images> XCursor::load_file(
+    const std::filesystem::path& path,
     const uint32_t size) {
-  std::istringstream file(std::string(buffer.begin(), buffer.end()),
-                          std::ios::binary);
-  const auto file_header = read_file_header(file);
-  if (!file_header) {
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
     return nullptr;
   }
-
-  size_t n_size;
-  const uint32_t best_size_ = best_size(*file_header, size, n_size);
-  if (!best_size_) {
+  struct stat st {};
+  if (fstat(fd, &st) < 0 || st.st_size <= 0) {
+    close(fd);
     return nullptr;
   }
-
-  auto images = create_images(n_size);
-  if (!images) {
-    return nullptr;
-  }
-
-  for (size_t n = 0; n < n_size; ++n) {
-    const int toc = find_image_toc(*file_header, best_size_, n);
-    if (toc < 0) {
-      break;
-    }
-
-    images->images.emplace_back(read_image(file, *file_header, toc));
-    if (!images->images[n]) {
-      break;
-    }
-  }
-
-  if (images->images.size() != n_size) {
-    destroy_images(images);
+  const auto length = static_cast<size_t>(st.st_size);
+  void* map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
     return nullptr;
   }
+  auto images = load_images(static_cast<const uint8_t*>(map), length, size);
+  munmap(map, length);
   return images;
 }
 }  // namespace drmpp
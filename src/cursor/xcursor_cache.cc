@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cursor/xcursor_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "cursor/xcursor_theme.h"
+
+namespace drmpp {
+/**
+ * @brief Source pixels covered by a destination pixel along one axis.
+ */
+struct BoxTap {
+  uint32_t first;              ///< First source pixel
+  std::vector<float> weights;  ///< Coverage of each source pixel
+};
+
+/**
+ * @brief Computes the box filter taps for one axis.
+ * @param src The source length.
+ * @param dst The destination length.
+ * @return One tap per destination pixel, weights summing to one.
+ */
+static std::vector<BoxTap> box_taps(const uint32_t src, const uint32_t dst) {
+  std::vector<BoxTap> taps(dst);
+  const double ratio = static_cast<double>(src) / dst;
+  for (uint32_t i = 0; i < dst; i++) {
+    const double begin = i * ratio;
+    const double end = std::min((i + 1) * ratio, static_cast<double>(src));
+    auto& tap = taps[i];
+    tap.first = static_cast<uint32_t>(begin);
+    for (auto s = tap.first; s < end; s++) {
+      const double covered =
+          std::min<double>(s + 1, end) - std::max<double>(s, begin);
+      tap.weights.push_back(static_cast<float>(covered / ratio));
+    }
+  }
+  return taps;
+}
+
+/**
+ * @brief Box filters premultiplied ARGB pixels.
+ *
+ * Separable, horizontal then vertical, on four float channels. The inner
+ * loops run over contiguous channel arrays so the compiler can vectorize
+ * them for the target.
+ *
+ * @param src The source pixels.
+ * @param src_width The source width.
+ * @param src_height The source height.
+ * @param dst The destination pixels, dst_width * dst_height.
+ * @param dst_width The destination width.
+ * @param dst_height The destination height.
+ */
+static void box_filter(const uint32_t* src,
+                       const uint32_t src_width,
+                       const uint32_t src_height,
+                       uint32_t* dst,
+                       const uint32_t dst_width,
+                       const uint32_t dst_height) {
+  const auto x_taps = box_taps(src_width, dst_width);
+  const auto y_taps = box_taps(src_height, dst_height);
+
+  // rows filtered horizontally, 4 channels per pixel
+  std::vector<float> rows(static_cast<size_t>(src_height) * dst_width * 4);
+  for (uint32_t y = 0; y < src_height; y++) {
+    const auto* line = src + static_cast<size_t>(y) * src_width;
+    auto* out = &rows[static_cast<size_t>(y) * dst_width * 4];
+    for (uint32_t x = 0; x < dst_width; x++, out += 4) {
+      const auto& tap = x_taps[x];
+      float acc[4] = {};
+      for (size_t k = 0; k < tap.weights.size(); k++) {
+        const auto pixel = line[tap.first + k];
+        const float w = tap.weights[k];
+        acc[0] += w * static_cast<float>(pixel >> 24);
+        acc[1] += w * static_cast<float>((pixel >> 16) & 0xff);
+        acc[2] += w * static_cast<float>((pixel >> 8) & 0xff);
+        acc[3] += w * static_cast<float>(pixel & 0xff);
+      }
+      std::copy_n(acc, 4, out);
+    }
+  }
+
+  std::vector<float> acc(static_cast<size_t>(dst_width) * 4);
+  for (uint32_t y = 0; y < dst_height; y++) {
+    const auto& tap = y_taps[y];
+    std::fill(acc.begin(), acc.end(), 0.0f);
+    for (size_t k = 0; k < tap.weights.size(); k++) {
+      const float w = tap.weights[k];
+      const auto* row = &rows[(tap.first + k) * acc.size()];
+      for (size_t i = 0; i < acc.size(); i++) {
+        acc[i] += w * row[i];
+      }
+    }
+    auto* out = dst + static_cast<size_t>(y) * dst_width;
+    for (uint32_t x = 0; x < dst_width; x++) {
+      uint32_t pixel = 0;
+      for (int c = 0; c < 4; c++) {
+        const auto v = std::lround(std::clamp(acc[x * 4 + c], 0.0f, 255.0f));
+        pixel = pixel << 8 | static_cast<uint32_t>(v);
+      }
+      out[x] = pixel;
+    }
+  }
+}
+
+XCursorCache::XCursorCache(const size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1)) {}
+
+XCursorCache& XCursorCache::get_shared() {
+  static XCursorCache cache;
+  return cache;
+}
+
+std::unique_ptr<XCursor::Images> XCursorCache::downscale(
+    const XCursor::Images& images,
+    const uint32_t size) {
+  auto result = XCursor::create_images(images.images.size());
+  result->name = images.name;
+  result->size = std::min(images.size, size);
+  const double ratio =
+      images.size > size ? static_cast<double>(size) / images.size : 1.0;
+
+  for (const auto& image : images.images) {
+    if (ratio == 1.0) {
+      result->images.emplace_back(std::make_unique<XCursor::Image>(*image));
+      continue;
+    }
+    const auto width = std::max<uint32_t>(
+        static_cast<uint32_t>(std::lround(image->width * ratio)), 1);
+    const auto height = std::max<uint32_t>(
+        static_cast<uint32_t>(std::lround(image->height * ratio)), 1);
+    auto scaled = XCursor::create_image(width, height);
+    scaled->xhot = std::min(
+        static_cast<uint32_t>(std::lround(image->xhot * ratio)), width - 1);
+    scaled->yhot = std::min(
+        static_cast<uint32_t>(std::lround(image->yhot * ratio)), height - 1);
+    scaled->delay = image->delay;
+    box_filter(image->pixels.data(), image->width, image->height,
+               scaled->pixels.data(), width, height);
+    result->images.emplace_back(std::move(scaled));
+  }
+  return result;
+}
+
+std::shared_ptr<XCursor::Images> XCursorCache::get(const std::string& theme,
+                                                   const std::string& name,
+                                                   const uint32_t size,
+                                                   const double scale) {
+  const auto target = std::max<uint32_t>(
+      static_cast<uint32_t>(std::lround(size * std::max(scale, 0.0))), 1);
+  // scale in 1/120 steps, as wp_fractional_scale_v1
+  auto key = theme;
+  key += '/';
+  key += name;
+  key += '@';
+  key += std::to_string(size);
+  key += 'x';
+  key += std::to_string(std::lround(scale * 120));
+
+  std::scoped_lock lock(mutex_);
+  if (const auto hit = cache_.find(key); hit != cache_.end()) {
+    lru_.splice(lru_.begin(), lru_, hit->second);
+    return hit->second->images;
+  }
+
+  const auto xcursor_theme = XCursorTheme::load(theme);
+  auto images = xcursor_theme->get_cursor(name, target);
+  if (!images) {
+    return nullptr;
+  }
+  if (images->size < target) {
+    // filter down from the largest size rather than show a small cursor
+    if (auto largest = xcursor_theme->get_cursor(
+            name, std::numeric_limits<uint32_t>::max());
+        largest && largest->size > images->size) {
+      images = std::move(largest);
+    }
+  }
+  if (images->size > target) {
+    images = downscale(*images, target);
+  }
+
+  lru_.push_front({key, images});
+  cache_.emplace(std::move(key), lru_.begin());
+  if (lru_.size() > capacity_) {
+    cache_.erase(lru_.back().key);
+    lru_.pop_back();
+  }
+  return images;
+}
+
+void XCursorCache::clear() {
+  std::scoped_lock lock(mutex_);
+  cache_.clear();
+  lru_.clear();
+}
+
+size_t XCursorCache::size() const {
+  std::scoped_lock lock(mutex_);
+  return lru_.size();
+}
+}  // namespace drmpp
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cursor/xcursor_theme.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "utils/utils.h"
+
+namespace drmpp {
+/// themes nested deeper than this are ignored, as in libXcursor
+static constexpr size_t kMaxInheritDepth = 16;
+
+XCursorTheme::XCursorTheme(std::string name, const size_t capacity)
+    : name_(std::move(name)), capacity_(std::max<size_t>(capacity, 1)) {
+  index_theme(name_);
+}
+
+std::shared_ptr<XCursorTheme> XCursorTheme::load(const std::string& name) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::shared_ptr<XCursorTheme>> themes;
+
+  std::scoped_lock lock(mutex);
+  auto& theme = themes[name];
+  if (!theme) {
+    theme = std::make_shared<XCursorTheme>(name);
+  }
+  return theme;
+}
+
+const std::vector<std::filesystem::path>& XCursorTheme::get_search_path() {
+  static const auto paths = [] {
+    std::vector<std::filesystem::path> result;
+    const char* home = getenv("HOME");
+    if (const char* env = getenv("XCURSOR_PATH"); env && *env) {
+      for (auto& path : utils::split(env, ":")) {
+        if (path.empty()) {
+          continue;
+        }
+        if (path[0] == '~') {
+          if (home) {
+            result.emplace_back(home + path.substr(1));
+          }
+        } else {
+          result.emplace_back(path);
+        }
+      }
+      return result;
+    }
+    if (home) {
+      result.emplace_back(std::filesystem::path(home) / ".local/share/icons");
+      result.emplace_back(std::filesystem::path(home) / ".icons");
+    }
+    result.emplace_back("/usr/share/icons");
+    result.emplace_back("/usr/share/pixmaps");
+    return result;
+  }();
+  return paths;
+}
+
+void XCursorTheme::index_theme(const std::string& theme) {
+  if (themes_.size() >= kMaxInheritDepth ||
+      std::find(themes_.begin(), themes_.end(), theme) != themes_.end()) {
+    return;
+  }
+  themes_.push_back(theme);
+
+  std::vector<std::string> inherits;
+  for (const auto& base : get_search_path()) {
+    std::error_code ec;
+    const auto dir = base / theme;
+    if (!std::filesystem::is_directory(dir, ec)) {
+      continue;
+    }
+    for (const auto& entry :
+         std::filesystem::directory_iterator(dir / "cursors", ec)) {
+      // names of a theme found earlier in the path or chain take precedence
+      auto cursor = entry.path().filename().string();
+      if (index_.count(cursor)) {
+        continue;
+      }
+      // aliases are symlinks, index their target so they share cache entries
+      auto path = std::filesystem::canonical(entry.path(), ec);
+      if (ec || !std::filesystem::is_regular_file(path, ec)) {
+        continue;
+      }
+      index_.emplace(std::move(cursor), std::move(path));
+    }
+    if (inherits.empty()) {
+      inherits = utils::read_ini_list(dir / "index.theme", "Inherits");
+    }
+  }
+
+  for (const auto& parent : inherits) {
+    index_theme(parent);
+  }
+}
+
+std::vector<std::string> XCursorTheme::get_cursor_names() const {
+  std::vector<std::string> names;
+  names.reserve(index_.size());
+  for (const auto& [name, path] : index_) {
+    names.push_back(name);
+  }
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+std::shared_ptr<XCursor::Images> XCursorTheme::get_cursor(
+    const std::string& name,
+    const uint32_t size) {
+  const auto it = index_.find(name);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+  auto key = it->second.string();
+  key += '@';
+  key += std::to_string(size);
+
+  std::scoped_lock lock(mutex_);
+  if (const auto hit = cache_.find(key); hit != cache_.end()) {
+    lru_.splice(lru_.begin(), lru_, hit->second);
+    return hit->second->images;
+  }
+
+  std::shared_ptr<XCursor::Images> images =
+      XCursor::load_file(it->second, size);
+  if (!images) {
+    LOG_WARN("Failed to load cursor: {}", it->second.string());
+    return nullptr;
+  }
+  // aliases share the images, so they carry the name of the file
+  images->name = it->second.filename().string();
+
+  lru_.push_front({key, images});
+  cache_.emplace(std::move(key), lru_.begin());
+  if (lru_.size() > capacity_) {
+    cache_.erase(lru_.back().key);
+    lru_.pop_back();
+  }
+  return images;
+}
+}  // namespace drmpp
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "input/event_recorder.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "logging/logging.h"
+
+namespace drmpp::input {
+EventRecorder::~EventRecorder() {
+  close();
+}
+
+bool EventRecorder::open(const std::string& path) {
+  close();
+
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    LOG_ERROR("Failed to open {}: {}", path, std::strerror(errno));
+    return false;
+  }
+  if (!grow()) {
+    close();
+    return false;
+  }
+
+  auto header = static_cast<EventTraceHeader*>(map_);
+  std::memcpy(header->magic, EventTraceHeader::kMagic, sizeof(header->magic));
+  header->version = EventTraceHeader::kVersion;
+  header->record_size = sizeof(EventRecord);
+  header->count = 0;
+  header->reserved = 0;
+  return true;
+}
+
+void EventRecorder::close() {
+  if (fd_ < 0) {
+    return;
+  }
+  if (map_) {
+    munmap(map_, map_size_);
+    map_ = nullptr;
+  }
+  // drop the unused tail of the last chunk
+  if (ftruncate(fd_, static_cast<off_t>(sizeof(EventTraceHeader) +
+                                        count_ * sizeof(EventRecord))) < 0) {
+    LOG_ERROR("ftruncate: {}", std::strerror(errno));
+  }
+  ::close(fd_);
+  fd_ = -1;
+  map_size_ = 0;
+  count_ = 0;
+  capacity_ = 0;
+}
+
+bool EventRecorder::grow() {
+  const auto capacity = capacity_ + kGrowRecords;
+  const auto size = sizeof(EventTraceHeader) + capacity * sizeof(EventRecord);
+  if (ftruncate(fd_, static_cast<off_t>(size)) < 0) {
+    LOG_ERROR("ftruncate: {}", std::strerror(errno));
+    return false;
+  }
+
+  void* map;
+  if (map_) {
+    map = mremap(map_, map_size_, size, MREMAP_MAYMOVE);
+  } else {
+    map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  }
+  if (map == MAP_FAILED) {
+    LOG_ERROR("Failed to map event trace: {}", std::strerror(errno));
+    return false;
+  }
+
+  map_ = map;
+  map_size_ = size;
+  capacity_ = capacity;
+  return true;
+}
+
+bool EventRecorder::append(const EventRecord& record) {
+  if (fd_ < 0) {
+    return false;
+  }
+  if (count_ == capacity_ && !grow()) {
+    return false;
+  }
+  auto records = reinterpret_cast<EventRecord*>(
+      static_cast<uint8_t*>(map_) + sizeof(EventTraceHeader));
+  records[count_++] = record;
+  // keep the header current so a trace from a process that exits without
+  // closing it remains readable
+  static_cast<EventTraceHeader*>(map_)->count = count_;
+  return true;
+}
+}  // namespace drmpp::input
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "input/event_replayer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "input/seat.h"
+#include "logging/logging.h"
+
+namespace drmpp::input {
+EventReplayer::~EventReplayer() {
+  close();
+}
+
+bool EventReplayer::open(const std::string& path) {
+  close();
+
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    LOG_ERROR("Failed to open {}: {}", path, std::strerror(errno));
+    return false;
+  }
+  struct stat st {};
+  if (fstat(fd, &st) < 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(EventTraceHeader)) {
+    LOG_ERROR("Invalid event trace: {}", path);
+    ::close(fd);
+    return false;
+  }
+
+  const auto size = static_cast<size_t>(st.st_size);
+  const auto map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) {
+    LOG_ERROR("Failed to map {}: {}", path, std::strerror(errno));
+    return false;
+  }
+  map_ = map;
+  map_size_ = size;
+
+  const auto header = static_cast<const EventTraceHeader*>(map_);
+  if (std::memcmp(header->magic, EventTraceHeader::kMagic,
+                  sizeof(header->magic)) != 0 ||
+      header->version != EventTraceHeader::kVersion ||
+      header->record_size != sizeof(EventRecord)) {
+    LOG_ERROR("Unsupported event trace: {}", path);
+    close();
+    return false;
+  }
+
+  // a trace that was not closed cleanly has a stale count
+  const uint64_t available =
+      (size - sizeof(EventTraceHeader)) / sizeof(EventRecord);
+  count_ = std::min(header->count, available);
+  records_ = reinterpret_cast<const EventRecord*>(
+      static_cast<const uint8_t*>(map_) + sizeof(EventTraceHeader));
+  madvise(map_, map_size_, MADV_SEQUENTIAL);
+  return true;
+}
+
+void EventReplayer::close() {
+  if (map_) {
+    munmap(map_, map_size_);
+  }
+  map_ = nullptr;
+  map_size_ = 0;
+  records_ = nullptr;
+  count_ = 0;
+}
+
+uint64_t EventReplayer::replay(Seat& seat, const bool realtime) const {
+  if (!records_ || count_ == 0) {
+    return 0;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  uint64_t base_usec = 0;
+  for (uint64_t i = 0; i < count_; i++) {
+    const auto& record = records_[i];
+    // device records carry no timestamp and are dispatched immediately
+    if (realtime && record.time_usec != 0) {
+      if (base_usec == 0) {
+        start = std::chrono::steady_clock::now();
+        base_usec = record.time_usec;
+      } else if (record.time_usec > base_usec) {
+        std::this_thread::sleep_until(
+            start + std::chrono::microseconds(record.time_usec - base_usec));
+      }
+    }
+    seat.handle_record(record);
+  }
+  return count_;
+}
+}  // namespace drmpp::input
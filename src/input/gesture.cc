@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "input/gesture.h"
+
+namespace drmpp::input {
+Gesture::Gesture(event_mask const& event_mask) {
+  event_mask_ = {
+      .enabled = event_mask.enabled,
+      .all = event_mask.all,
+  };
+}
+
+void Gesture::set_event_mask(event_mask const& event_mask) {
+  event_mask_.enabled = event_mask.enabled;
+  event_mask_.all = event_mask.all;
+  if (is_masked()) {
+    update_ = {};
+  }
+}
+
+void Gesture::set_motion_coalescing(const bool enable) {
+  if (!enable) {
+    flush_motion();
+  }
+  coalesce_ = enable;
+}
+
+void Gesture::flush_motion() {
+  if (!update_.pending) {
+    return;
+  }
+  update_.pending = false;
+  if (update_.pinch) {
+    observers_.for_each([&](GestureObserver* observer) {
+      observer->notify_gesture_pinch_update(
+          this, update_.time, update_.fingers, update_.dx, update_.dy,
+          update_.scale, update_.angle_delta);
+    });
+  } else {
+    observers_.for_each([&](GestureObserver* observer) {
+      observer->notify_gesture_swipe_update(this, update_.time, update_.fingers,
+                                            update_.dx, update_.dy);
+    });
+  }
+}
+
+void Gesture::handle_swipe_begin(const uint32_t time, const uint32_t fingers) {
+  if (is_masked()) {
+    return;
+  }
+  flush_motion();
+  observers_.for_each([&](GestureObserver* observer) {
+    observer->notify_gesture_swipe_begin(this, time, fingers);
+  });
+}
+
+void Gesture::handle_swipe_update(const uint32_t time,
+                                  const uint32_t fingers,
+                                  const double dx,
+                                  const double dy) {
+  if (is_masked()) {
+    return;
+  }
+  if (coalesce_) {
+    if (!update_.pending || update_.pinch) {
+      flush_motion();
+      update_ = {.pending = true, .pinch = false};
+    }
+    update_.time = time;
+    update_.fingers = fingers;
+    update_.dx += dx;
+    update_.dy += dy;
+    return;
+  }
+  observers_.for_each([&](GestureObserver* observer) {
+    observer->notify_gesture_swipe_update(this, time, fingers, dx, dy);
+  });
+}
+
+void Gesture::handle_swipe_end(const uint32_t time,
+                               const uint32_t fingers,
+                               const bool cancelled) {
+  if (is_masked()) {
+    return;
+  }
+  flush_motion();
+  observers_.for_each([&](GestureObserver* observer) {
+    observer->notify_gesture_swipe_end(this, time, fingers, cancelled);
+  });
+}
+
+void Gesture::handle_pinch_begin(const uint32_t time, const uint32_t fingers) {
+  if (is_masked()) {
+    return;
+  }
+  flush_motion();
+  observers_.for_each([&](GestureObserver* observer) {
+    observer->notify_gesture_pinch_begin(this, time, fingers);
+  });
+}
+
+void Gesture::handle_pinch_update(const uint32_t time,
+                                  const uint32_t fingers,
+                                  const double dx,
+                                  const double dy,
+                                  const double scale,
+                                  const double angle_delta) {
+  if (is_masked()) {
+    return;
+  }
+  if (coalesce_) {
+    if (!update_.pending || !update_.pinch) {
+      flush_motion();
+      update_ = {.pending = true, .pinch = true};
+    }
+    update_.time = time;
+    update_.fingers = fingers;
+    update_.dx += dx;
+    update_.dy += dy;
+    update_.scale = scale;
+    update_.angle_delta += angle_delta;
+    return;
+  }
+  observers_.for_each([&](GestureObserver* observer) {
+    observer->notify_gesture_pinch_update(this, time, fingers, dx, dy, scale,
+                                          angle_delta);
+  });
+}
+
+void Gesture::handle_pinch_end(const uint32_t time,
+                               const uint32_t fingers,
+                               const bool cancelled) {
+  if (is_masked()) {
+    return;
+  }
+  flush_motion();
+  observers_.for_each([&](GestureObserver* observer) {
+    observer->notify_gesture_pinch_end(this, time, fingers, cancelled);
+  });
+}
+
+void Gesture::handle_hold_begin(const uint32_t time, const uint32_t fingers) {
+  if (is_masked()) {
+    return;
+  }
+  flush_motion();
+  observers_.for_each([&](GestureObserver* observer) {
+    observer->notify_gesture_hold_begin(this, time, fingers);
+  });
+}
+
+void Gesture::handle_hold_end(const uint32_t time,
+                              const uint32_t fingers,
+                              const bool cancelled) {
+  if (is_masked()) {
+    return;
+  }
+  flush_motion();
+  observers_.for_each([&](GestureObserver* observer) {
+    observer->notify_gesture_hold_end(this, time, fingers, cancelled);
+  });
+}
+}  // namespace drmpp::input
@@ -17,50 +17,49 @@
 #include "input/keyboard.h"
 
 #include <filesystem>
+#include <fstream>
 
+#include <strings.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 #include <cstdio>
 #include <ctime>
 
-#include "input/default_xkeymap.h"
 #include "utils/utils.h"
 
 namespace drmpp::input {
 Keyboard::Keyboard(event_mask const& event_mask,
+                   std::shared_ptr<KeymapCache> keymap_cache,
                    const char* model,
                    const char* layout,
                    const char* variant,
                    const char* options,
                    const int32_t delay,
-                   const int32_t repeat) {
-  (void)model;
-  (void)layout;
-  (void)variant;
-  (void)options;
+                   const int32_t repeat)
+    : keymap_cache_(std::move(keymap_cache)) {
   event_mask_ = {
       .enabled = event_mask.enabled,
       .all = event_mask.all,
   };
-  xkb_context_ = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
-  xkb_context_set_log_verbosity(xkb_context_, XKB_LOG_LEVEL_INFO);
-  load_default_keymap();
+  if (!keymap_cache_) {
+    keymap_cache_ = std::make_shared<KeymapCache>();
+  }
+  set_keymap(
+      keymap_cache_->get_keymap(nullptr, model, layout, variant, options));
   handle_repeat_info(delay, repeat);
 }
 
 Keyboard::~Keyboard() {
+  if (repeat_.fd >= 0) {
+    close(repeat_.fd);
+  }
   if (xkb_state_) {
     xkb_state_unref(xkb_state_);
   }
-  if (xkb_keymap_) {
-    xkb_keymap_unref(xkb_keymap_);
-  }
-  if (xkb_context_) {
-    xkb_context_unref(xkb_context_);
-  }
 }
 
 void Keyboard::register_observer(KeyboardObserver* observer, void* user_data) {
-  std::scoped_lock lock(observers_mutex_);
-  observers_.push_back(observer);
+  observers_.add(observer);
 
   if (user_data) {
     user_data_ = user_data;
@@ -68,25 +67,104 @@ void Keyboard::register_observer(KeyboardObserver* observer, void* user_data) {
 }
 
 void Keyboard::unregister_observer(KeyboardObserver* observer) {
-  std::scoped_lock lock(observers_mutex_);
   observers_.remove(observer);
 }
 
-void Keyboard::load_default_keymap() {
-  if (xkb_keymap_) {
-    xkb_keymap_unref(xkb_keymap_);
-  }
-
-  auto buffer = utils::decompress_lz_asset(kDefaultXKeymap.data,
-                                           kDefaultXKeymap.compressed_size,
-                                           kDefaultXKeymap.uncompressed_size);
-  xkb_keymap_ = xkb_keymap_new_from_buffer(
-      xkb_context_, reinterpret_cast<const char*>(buffer.data()), buffer.size(),
-      XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
-  buffer.clear();
-  assert(xkb_keymap_);
-  xkb_state_unref(xkb_state_);
-  xkb_state_ = xkb_state_new(xkb_keymap_);
+void Keyboard::set_keymap(std::shared_ptr<xkb_keymap> keymap) {
+  assert(keymap);
+  xkb_keymap_ = std::move(keymap);
+  if (xkb_state_) {
+    xkb_state_unref(xkb_state_);
+  }
+  xkb_state_ = xkb_state_new(xkb_keymap_.get());
+
+  static constexpr const char* kModNames[MODIFIER_COUNT] = {
+      XKB_MOD_NAME_SHIFT, XKB_MOD_NAME_CAPS, XKB_MOD_NAME_CTRL,
+      XKB_MOD_NAME_ALT,   XKB_MOD_NAME_NUM,  XKB_MOD_NAME_LOGO,
+  };
+  for (size_t i = 0; i < mod_indices_.size(); i++) {
+    mod_indices_[i] = xkb_keymap_mod_get_index(xkb_keymap_.get(), kModNames[i]);
+  }
+  pressed_keys_.reset();
+  modifiers_ = {};
+  key_table_.valid = false;
+}
+
+void Keyboard::build_key_table() {
+  const auto keymap = xkb_keymap_.get();
+  const auto min_keycode = xkb_keymap_min_keycode(keymap);
+  const auto max_keycode = xkb_keymap_max_keycode(keymap);
+  key_table_.layout =
+      xkb_state_serialize_layout(xkb_state_, XKB_STATE_LAYOUT_EFFECTIVE);
+  key_table_.min_keycode = min_keycode;
+  key_table_.keys.assign(max_keycode - min_keycode + 1, {});
+
+  for (auto keycode = min_keycode; keycode <= max_keycode; keycode++) {
+    auto& levels = key_table_.keys[keycode - min_keycode];
+    // keys with fewer layouts wrap the effective layout
+    const auto layout = xkb_state_key_get_layout(xkb_state_, keycode);
+    if (layout == XKB_LAYOUT_INVALID) {
+      continue;
+    }
+    const auto num_levels =
+        std::min(xkb_keymap_num_levels_for_key(keymap, keycode, layout),
+                 kTableLevels);
+    for (xkb_level_index_t level = 0; level < num_levels; level++) {
+      const xkb_keysym_t* syms;
+      if (xkb_keymap_key_get_syms_by_level(keymap, keycode, layout, level,
+                                           &syms) == 1) {
+        levels[level] = {.keysym = syms[0],
+                         .utf32 = xkb_keysym_to_utf32(syms[0])};
+      }
+    }
+  }
+  key_table_.valid = true;
+}
+
+const Keyboard::key_level* Keyboard::lookup_key(
+    const xkb_keycode_t xkb_scancode) {
+  if (!key_table_.valid) {
+    build_key_table();
+  }
+  if (xkb_scancode < key_table_.min_keycode ||
+      xkb_scancode - key_table_.min_keycode >= key_table_.keys.size()) {
+    return nullptr;
+  }
+  const auto layout = xkb_state_key_get_layout(xkb_state_, xkb_scancode);
+  const auto level = xkb_state_key_get_level(xkb_state_, xkb_scancode, layout);
+  if (level >= kTableLevels) {
+    return nullptr;
+  }
+  const auto& entry =
+      key_table_.keys[xkb_scancode - key_table_.min_keycode][level];
+  return entry.keysym != XKB_KEY_NoSymbol ? &entry : nullptr;
+}
+
+bool Keyboard::is_modifier_active(const Modifier modifier) const {
+  const auto index = mod_indices_[modifier];
+  if (index == XKB_MOD_INVALID) {
+    return false;
+  }
+  const auto mask =
+      modifiers_.depressed | modifiers_.latched | modifiers_.locked;
+  return (mask >> index) & 1;
+}
+
+xkb_keysym_t Keyboard::get_keysym(const uint32_t xkb_scancode) {
+  if (const auto entry = lookup_key(xkb_scancode)) {
+    return entry->keysym;
+  }
+  return xkb_state_key_get_one_sym(xkb_state_, xkb_scancode);
+}
+
+uint32_t Keyboard::get_utf32(const uint32_t xkb_scancode) {
+  if (!is_modifier_active(MODIFIER_CTRL) &&
+      !is_modifier_active(MODIFIER_CAPS)) {
+    if (const auto entry = lookup_key(xkb_scancode)) {
+      return entry->utf32;
+    }
+  }
+  return xkb_state_key_get_utf32(xkb_state_, xkb_scancode);
 }
 
 void Keyboard::load_keymap_from_file(const std::string& keymap_file) {
@@ -135,181 +213,349 @@ void Keyboard::load_keymap_from_file(const std::string& keymap_file) {
     DLOG_DEBUG("Failed to load file: {}", file);
     return;
   }
-  xkb_keymap_unref(xkb_keymap_);
-  xkb_keymap_ = xkb_keymap_new_from_file(
-      xkb_context_, f, XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
+  const auto keymap =
+      xkb_keymap_new_from_file(keymap_cache_->get_context(), f,
+                               XKB_KEYMAP_FORMAT_TEXT_V1,
+                               XKB_KEYMAP_COMPILE_NO_FLAGS);
   fclose(f);
-  xkb_state_unref(xkb_state_);
-  xkb_state_ = xkb_state_new(xkb_keymap_);
+  if (!keymap) {
+    LOG_ERROR("Failed to compile keymap file: {}", file);
+    return;
+  }
+  set_keymap({keymap, xkb_keymap_unref});
 }
 
 void Keyboard::handle_keyboard_event(libinput_event_keyboard* key_event) {
-  const auto key = libinput_event_keyboard_get_key(key_event);
-  const auto state = libinput_event_keyboard_get_key_state(key_event);
-  auto time = libinput_event_keyboard_get_time(key_event);
+  handle_key(libinput_event_keyboard_get_time(key_event),
+             libinput_event_keyboard_get_key(key_event),
+             libinput_event_keyboard_get_key_state(key_event));
+}
+
+void Keyboard::handle_key(const uint32_t time,
+                          const uint32_t key,
+                          const libinput_key_state state) {
+  if (event_mask_.enabled && event_mask_.all) {
+    return;
+  }
 
   /// translate scancode to XKB scancode
   const auto xkb_scancode = key + 8;
-  const auto key_repeats = xkb_keymap_key_repeats(xkb_keymap_, xkb_scancode);
+  const auto key_repeats =
+      xkb_keymap_key_repeats(xkb_keymap_.get(), xkb_scancode);
 
+  const bool pressed = state == LIBINPUT_KEY_STATE_PRESSED;
   const xkb_keysym_t* key_symbols;
   const auto xdg_keysym_count =
       xkb_state_key_get_syms(xkb_state_, xkb_scancode, &key_symbols);
+  const uint32_t utf32 = pressed ? get_utf32(xkb_scancode) : 0;
 
-  if (key_repeats) {
-    // start/restart timer
-    itimerspec in{};
-    in.it_value.tv_nsec = repeat_.delay * 1000000;
-    in.it_interval.tv_nsec = repeat_.rate * 1000000;
-    timer_settime(repeat_.timer, 0, &in, nullptr);
-
-    // update notify values
-    repeat_.notify = {.time = time,
-                      .xkb_scancode = xkb_scancode,
-                      .key_repeats = key_repeats,
-                      .xdg_keysym_count = xdg_keysym_count,
-                      .key_syms = key_symbols};
-  }
-
-  if (state == LIBINPUT_KEY_STATE_RELEASED) {
-    if (repeat_.notify.xkb_scancode == xkb_scancode) {
-      // stop timer
-      constexpr itimerspec its{};
-      timer_settime(repeat_.timer, 0, &its, nullptr);
+  // the key's own symbols are resolved before it changes the state
+  if (key < kMaxKeys) {
+    pressed_keys_.set(key, pressed);
+  }
+  const auto changed = xkb_state_update_key(
+      xkb_state_, xkb_scancode, pressed ? XKB_KEY_DOWN : XKB_KEY_UP);
+  if (changed & (XKB_STATE_MODS_DEPRESSED | XKB_STATE_MODS_LATCHED |
+                 XKB_STATE_MODS_LOCKED | XKB_STATE_LAYOUT_EFFECTIVE)) {
+    modifiers_ = {
+        .depressed =
+            xkb_state_serialize_mods(xkb_state_, XKB_STATE_MODS_DEPRESSED),
+        .latched = xkb_state_serialize_mods(xkb_state_, XKB_STATE_MODS_LATCHED),
+        .locked = xkb_state_serialize_mods(xkb_state_, XKB_STATE_MODS_LOCKED),
+        .layout =
+            xkb_state_serialize_layout(xkb_state_, XKB_STATE_LAYOUT_EFFECTIVE),
+    };
+    if (modifiers_.layout != key_table_.layout) {
+      key_table_.valid = false;
+    }
+  }
+
+  if (pressed) {
+    if (key_repeats) {
+      repeat_.notify = {.time = time,
+                        .xkb_scancode = xkb_scancode,
+                        .key_repeats = key_repeats};
+      repeat_.count = 0;
+      set_repeat_timer(true);
     }
+  } else if (repeat_.notify.xkb_scancode == xkb_scancode) {
+    set_repeat_timer(false);
   }
 
   DLOG_TRACE(
       "Key: time: {}, xkb_scancode: 0x{:X}, key_repeats: {}, state: {}, "
-      "xdg_keysym_count: {}, syms_out[0]: 0x{:X}",
-      time, xkb_scancode, key_repeats,
-      state == LIBINPUT_KEY_STATE_PRESSED ? "press" : "release",
-      xdg_keysym_count, key_symbols[0]);
+      "xdg_keysym_count: {}, syms_out[0]: 0x{:X}, utf32: U+{:04X}",
+      time, xkb_scancode, key_repeats, pressed ? "press" : "release",
+      xdg_keysym_count, key_symbols[0], utf32);
 
-  if (event_mask_.enabled && event_mask_.all) {
-    return;
-  }
-
-  std::scoped_lock lock(observers_mutex_);
-  for (const auto observer : observers_) {
+  observers_.for_each([&](KeyboardObserver* observer) {
     observer->notify_keyboard_xkb_v1_key(this, time, xkb_scancode, key_repeats,
-                                         state, xdg_keysym_count, key_symbols);
-  }
+                                         state, xdg_keysym_count, key_symbols,
+                                         utf32);
+  });
 }
 
 void Keyboard::handle_repeat_info(const int32_t delay, const int32_t rate) {
   repeat_.rate = rate;
   repeat_.delay = delay;
 
-  if (!repeat_.timer) {
-    /// Setup signal event
-    repeat_.sev.sigev_notify = SIGEV_SIGNAL;
-    repeat_.sev.sigev_signo = SIGRTMIN;
-    repeat_.sev.sigev_value.sival_ptr = this;
-    if (const auto res =
-            timer_create(CLOCK_REALTIME, &repeat_.sev, &repeat_.timer);
-        res != 0) {
-      LOG_CRITICAL("Error timer_create: {}", std::strerror(errno));
+  if (repeat_.fd < 0) {
+    repeat_.fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (repeat_.fd < 0) {
+      LOG_CRITICAL("Error timerfd_create: {}", std::strerror(errno));
       abort();
     }
+  }
+}
 
-    /// Setup signal action
-    repeat_.sa.sa_flags = SA_SIGINFO;
-    repeat_.sa.sa_sigaction = repeat_xkb_v1_key_callback;
-    sigemptyset(&repeat_.sa.sa_mask);
-    if (sigaction(SIGRTMIN, &repeat_.sa, nullptr) == -1) {
-      LOG_CRITICAL("Error sigaction: {}", std::strerror(errno));
-      abort();
-    }
+void Keyboard::set_repeat_timer(const bool arm) const {
+  itimerspec its{};
+  if (arm) {
+    its.it_value.tv_sec = repeat_.delay / 1000;
+    its.it_value.tv_nsec = (repeat_.delay % 1000) * 1000000L;
+    its.it_interval.tv_sec = repeat_.rate / 1000;
+    its.it_interval.tv_nsec = (repeat_.rate % 1000) * 1000000L;
+  }
+  if (timerfd_settime(repeat_.fd, 0, &its, nullptr) < 0) {
+    LOG_ERROR("Error timerfd_settime: {}", std::strerror(errno));
   }
 }
 
-void Keyboard::repeat_xkb_v1_key_callback(int /* sig */,
-                                          siginfo_t* si,  // NOLINT
-                                          void* /* uc */) {
-  const auto obj =
-      static_cast<Keyboard*>(si->_sifields._rt.si_sigval.sival_ptr);
+void Keyboard::handle_repeat() {
+  uint64_t expirations;
+  if (read(repeat_.fd, &expirations, sizeof(expirations)) !=
+      sizeof(expirations)) {
+    return;
+  }
 
-  LOG_INFO(
-      "Key: time: {}, xkb_scancode: 0x{:X}, key_repeats: {}, state: {}, "
-      "xdg_keysym_count: {}, syms_out[0]: 0x{:X}",
-      obj->repeat_.notify.time, obj->repeat_.notify.xkb_scancode,
-      obj->repeat_.notify.key_repeats, "pressed",
-      obj->repeat_.notify.xdg_keysym_count, obj->repeat_.notify.key_syms[0]);
-}
+  const auto xkb_scancode = repeat_.notify.xkb_scancode;
+  const xkb_keysym_t* key_symbols;
+  const auto xdg_keysym_count =
+      xkb_state_key_get_syms(xkb_state_, xkb_scancode, &key_symbols);
+  const auto utf32 = get_utf32(xkb_scancode);
 
-std::pair<std::string, std::string> Keyboard::get_keymap_filepath() {
-  std::string keymap_dir = "/usr/share/X11/xkb/symbols/";
-  if (!std::filesystem::exists(keymap_dir)) {
-    keymap_dir = "/usr/X11/xkb/symbols/";
-    if (!std::filesystem::exists(keymap_dir)) {
-      LOG_WARN("xkb keymaps are not installed");
-      return {};
+  for (uint64_t i = 0; i < expirations; i++) {
+    const uint32_t time = repeat_.notify.time + repeat_.delay +
+                          repeat_.count * static_cast<uint32_t>(repeat_.rate);
+    repeat_.count++;
+
+    DLOG_TRACE("Key Repeat: time: {}, xkb_scancode: 0x{:X}", time,
+               xkb_scancode);
+
+    if (event_mask_.enabled && event_mask_.all) {
+      continue;
     }
+
+    observers_.for_each([&](KeyboardObserver* observer) {
+      observer->notify_keyboard_xkb_v1_key(
+          this, time, xkb_scancode, repeat_.notify.key_repeats,
+          LIBINPUT_KEY_STATE_PRESSED, xdg_keysym_count, key_symbols, utf32);
+    });
   }
+}
 
-  std::string xkb_layout;
-  std::string xkb_variant;
+namespace {
+/**
+ * \brief Strips surrounding whitespace and a single level of quotes.
+ *
+ * \param value The value to clean up.
+ * \return The unquoted value.
+ */
+std::string unquote(std::string value) {
+  utils::trim(value, " \t\r");
+  if (value.size() >= 2 && (value.front() == '"' || value.front() == '\'') &&
+      value.back() == value.front()) {
+    value = value.substr(1, value.size() - 2);
+  }
+  return value;
+}
 
-  // try with localectl first in case of default override
-  if (utils::is_cmd_present("localectl")) {
-    constexpr char cmd[] = "localectl status";
-    std::string result;
-    if (!utils::execute(cmd, result)) {
-      LOG_ERROR("Failed to run {}", cmd);
-      return {};
+/**
+ * \brief Reads XKBLAYOUT and XKBVARIANT from a shell style KEY=value file.
+ *
+ * Used for /etc/default/keyboard and /etc/vconsole.conf.
+ *
+ * \param path The file to read.
+ * \param layout Receives the layout, if present.
+ * \param variant Receives the variant, if present.
+ * \return True if a layout was found, false otherwise.
+ */
+bool read_xkb_env_file(const char* path,
+                       std::string& layout,
+                       std::string& variant) {
+  std::ifstream file(path);
+  if (!file) {
+    return false;
+  }
+  std::string line;
+  std::string file_layout;
+  std::string file_variant;
+  while (std::getline(file, line)) {
+    utils::ltrim(line, " \t");
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    const auto pos = line.find('=');
+    if (pos == std::string::npos) {
+      continue;
+    }
+    auto key = line.substr(0, pos);
+    utils::rtrim(key, " \t");
+    if (key == "XKBLAYOUT") {
+      file_layout = unquote(line.substr(pos + 1));
+    } else if (key == "XKBVARIANT") {
+      file_variant = unquote(line.substr(pos + 1));
+    }
+  }
+  if (file_layout.empty()) {
+    return false;
+  }
+  layout = std::move(file_layout);
+  variant = std::move(file_variant);
+  return true;
+}
+
+/**
+ * \brief Reads XkbLayout and XkbVariant options from an xorg.conf snippet.
+ *
+ * This is the file localed maintains, and what `localectl status` reports as
+ * the X11 layout.
+ *
+ * \param path The file to read.
+ * \param layout Receives the layout, if present.
+ * \param variant Receives the variant, if present.
+ * \return True if a layout was found, false otherwise.
+ */
+bool read_xorg_conf(const std::filesystem::path& path,
+                    std::string& layout,
+                    std::string& variant) {
+  std::ifstream file(path);
+  if (!file) {
+    return false;
+  }
+  std::string line;
+  std::string file_layout;
+  std::string file_variant;
+  while (std::getline(file, line)) {
+    utils::ltrim(line, " \t");
+    if (line.compare(0, 6, "Option") != 0) {
+      continue;
     }
-    auto lines = utils::split(result, "\n");
-    for (auto const& line : lines) {
-      DLOG_TRACE("Line: [{}]", line);
-      if (line.find("X11 Layout") != std::string::npos) {
-        auto tokens = utils::split(line, ":");
-        xkb_layout = utils::trim(tokens[1], " ");
+    // Option "XkbLayout" "us"
+    std::vector<std::string> fields;
+    size_t pos = 0;
+    while ((pos = line.find('"', pos)) != std::string::npos) {
+      const auto end = line.find('"', pos + 1);
+      if (end == std::string::npos) {
         break;
-      };
+      }
+      fields.emplace_back(line.substr(pos + 1, end - pos - 1));
+      pos = end + 1;
     }
-    DLOG_TRACE("xkb_layout: [{}]", xkb_layout);
-    DLOG_TRACE("xkb_variant: [{}]", xkb_variant);
-    auto keymap_filepath = keymap_dir + xkb_layout;
-    if (!std::filesystem::exists(keymap_filepath)) {
-      LOG_ERROR("Keymap File does not exist: {}", keymap_filepath);
-      return {};
+    if (fields.size() < 2) {
+      continue;
     }
-    return std::make_pair(keymap_filepath, xkb_variant);
+    if (strcasecmp(fields[0].c_str(), "XkbLayout") == 0) {
+      file_layout = fields[1];
+    } else if (strcasecmp(fields[0].c_str(), "XkbVariant") == 0) {
+      file_variant = fields[1];
+    }
+  }
+  if (file_layout.empty()) {
+    return false;
   }
+  layout = std::move(file_layout);
+  variant = std::move(file_variant);
+  return true;
+}
 
-  // read the system default
-  if (std::filesystem::exists("/etc/default/keyboard")) {
-    constexpr char cmd[] = "cat /etc/default/keyboard";
-    std::string result;
-    if (!utils::execute(cmd, result)) {
-      LOG_ERROR("Failed to run {}", cmd);
+/**
+ * \brief Looks up the configured xkb layout and variant.
+ *
+ * xorg.conf.d takes precedence, as localectl would report, followed by
+ * /etc/default/keyboard and /etc/vconsole.conf.
+ *
+ * \param layout Receives the layout.
+ * \param variant Receives the variant.
+ * \return True if a layout was found, false otherwise.
+ */
+bool find_xkb_layout(std::string& layout, std::string& variant) {
+  constexpr char xorg_conf_dir[] = "/etc/X11/xorg.conf.d";
+  std::error_code ec;
+  if (std::filesystem::is_directory(xorg_conf_dir, ec)) {
+    std::vector<std::filesystem::path> confs;
+    for (const auto& entry :
+         std::filesystem::directory_iterator(xorg_conf_dir, ec)) {
+      if (entry.path().extension() == ".conf") {
+        confs.push_back(entry.path());
+      }
+    }
+    std::sort(confs.begin(), confs.end());
+    for (const auto& conf : confs) {
+      if (read_xorg_conf(conf, layout, variant)) {
+        DLOG_TRACE("xkb layout from {}", conf.string());
+        return true;
+      }
     }
-    auto lines = utils::split(result, "\n");
-    for (auto const& line : lines) {
-      if (line.find("XKBLAYOUT=") != std::string::npos) {
-        auto tokens = utils::split(line, "=");
-        xkb_layout = utils::trim(tokens[1], "\"");
-      } else if (line.find("XKBVARIANT=") != std::string::npos) {
-        auto tokens = utils::split(line, "=");
-        xkb_variant = utils::trim(tokens[1], "\"");
-      };
+  }
+  for (const auto path : {"/etc/default/keyboard", "/etc/vconsole.conf"}) {
+    if (read_xkb_env_file(path, layout, variant)) {
+      DLOG_TRACE("xkb layout from {}", path);
+      return true;
     }
+  }
+  return false;
+}
+}  // namespace
+
+std::pair<std::string, std::string> Keyboard::get_keymap_filepath() {
+  // The configuration does not change while we run, resolve it once.
+  static const auto keymap_filepath = []() -> std::pair<std::string,
+                                                        std::string> {
+    std::string keymap_dir = "/usr/share/X11/xkb/symbols/";
+    if (!std::filesystem::exists(keymap_dir)) {
+      keymap_dir = "/usr/X11/xkb/symbols/";
+      if (!std::filesystem::exists(keymap_dir)) {
+        LOG_WARN("xkb keymaps are not installed");
+        return {};
+      }
+    }
+
+    std::string xkb_layout;
+    std::string xkb_variant;
+    if (!find_xkb_layout(xkb_layout, xkb_variant)) {
+      LOG_WARN("Not able to detect xkb keymap values");
+      return {};
+    }
+
+    // Multi-layout configurations list the primary layout first.
+    xkb_layout = xkb_layout.substr(0, xkb_layout.find(','));
+    xkb_variant = xkb_variant.substr(0, xkb_variant.find(','));
     DLOG_TRACE("xkb_layout: [{}]", xkb_layout);
     DLOG_TRACE("xkb_variant: [{}]", xkb_variant);
-    auto keymap_filepath = keymap_dir + xkb_layout;
-    if (!std::filesystem::exists(keymap_filepath)) {
-      LOG_ERROR("Keymap File does not exist: {}", keymap_filepath);
+
+    auto path = keymap_dir + xkb_layout;
+    if (!std::filesystem::exists(path)) {
+      LOG_ERROR("Keymap File does not exist: {}", path);
       return {};
     }
-    return std::make_pair(keymap_filepath, xkb_variant);
-  }
-  LOG_WARN("Not able to detect xkb keymap values");
-  return {};
+    return std::make_pair(path, xkb_variant);
+  }();
+  return keymap_filepath;
 }
 
 void Keyboard::set_event_mask(event_mask const& event_mask) {
   event_mask_.enabled = event_mask.enabled;
   event_mask_.all = event_mask.all;
+  if (event_mask_.enabled && event_mask_.all) {
+    if (repeat_.fd >= 0) {
+      // a key held while masking would otherwise keep waking the loop
+      set_repeat_timer(false);
+    }
+    // releases are not seen while masked, start over from a clean state
+    if (xkb_keymap_ && pressed_keys_.any()) {
+      set_keymap(xkb_keymap_);
+    }
+  }
 }
 }  // namespace drmpp::input
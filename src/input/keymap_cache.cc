@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "input/keymap_cache.h"
+
+#include "input/default_xkeymap.h"
+#include "utils/utils.h"
+
+namespace drmpp::input {
+KeymapCache::KeymapCache() {
+  xkb_context_ = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+  xkb_context_set_log_verbosity(xkb_context_, XKB_LOG_LEVEL_INFO);
+}
+
+KeymapCache::~KeymapCache() {
+  keymaps_.clear();
+  default_keymap_.reset();
+  if (xkb_context_) {
+    xkb_context_unref(xkb_context_);
+  }
+}
+
+std::shared_ptr<xkb_keymap> KeymapCache::wrap(xkb_keymap* keymap) {
+  if (!keymap) {
+    return nullptr;
+  }
+  return {keymap, xkb_keymap_unref};
+}
+
+std::shared_ptr<xkb_keymap> KeymapCache::load_default_keymap() {
+  if (!default_keymap_) {
+    auto buffer = utils::decompress_lz_asset(kDefaultXKeymap.data,
+                                             kDefaultXKeymap.compressed_size,
+                                             kDefaultXKeymap.uncompressed_size);
+    default_keymap_ = wrap(xkb_keymap_new_from_buffer(
+        xkb_context_, reinterpret_cast<const char*>(buffer.data()),
+        buffer.size(), XKB_KEYMAP_FORMAT_TEXT_V1,
+        XKB_KEYMAP_COMPILE_NO_FLAGS));
+    if (!default_keymap_) {
+      LOG_ERROR("Failed to compile the default keymap");
+    }
+  }
+  return default_keymap_;
+}
+
+std::shared_ptr<xkb_keymap> KeymapCache::get_default_keymap() {
+  std::scoped_lock lock(mutex_);
+  return load_default_keymap();
+}
+
+std::shared_ptr<xkb_keymap> KeymapCache::get_keymap(const char* rules,
+                                                    const char* model,
+                                                    const char* layout,
+                                                    const char* variant,
+                                                    const char* options) {
+  std::scoped_lock lock(mutex_);
+  if (!layout || !*layout) {
+    return load_default_keymap();
+  }
+
+  Key key{rules ? rules : "", model ? model : "", layout,
+          variant ? variant : "", options ? options : ""};
+  if (const auto it = keymaps_.find(key); it != keymaps_.end()) {
+    return it->second;
+  }
+
+  const xkb_rule_names names = {
+      .rules = rules,
+      .model = model,
+      .layout = layout,
+      .variant = variant,
+      .options = options,
+  };
+  auto keymap = wrap(xkb_keymap_new_from_names(xkb_context_, &names,
+                                               XKB_KEYMAP_COMPILE_NO_FLAGS));
+  if (!keymap) {
+    // remember the failure so a replugged device does not retry
+    LOG_WARN("Failed to compile keymap for layout {}, using default", layout);
+    keymap = load_default_keymap();
+  }
+  keymaps_.emplace(std::move(key), keymap);
+  return keymap;
+}
+
+size_t KeymapCache::size() const {
+  std::scoped_lock lock(mutex_);
+  return keymaps_.size() + (default_keymap_ ? 1 : 0);
+}
+}  // namespace drmpp::input
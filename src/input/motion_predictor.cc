@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "input/motion_predictor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace drmpp::input {
+void MotionPredictor::reset() {
+  state_ = {};
+}
+
+void MotionPredictor::update(const uint64_t time_usec,
+                             const double x,
+                             const double y) {
+  if (state_.samples == 0 || time_usec < state_.time_usec ||
+      time_usec - state_.time_usec > params_.idle_reset_usec) {
+    state_ = {};
+    state_.x = x;
+    state_.y = y;
+    state_.time_usec = time_usec;
+    state_.samples = 1;
+    return;
+  }
+
+  // several samples with one timestamp only move the position
+  if (time_usec == state_.time_usec) {
+    state_.x = x;
+    state_.y = y;
+    return;
+  }
+
+  const double dt = static_cast<double>(time_usec - state_.time_usec) / 1e6;
+  const double rx = x - (state_.x + state_.vx * dt);
+  const double ry = y - (state_.y + state_.vy * dt);
+
+  state_.x += state_.vx * dt + params_.alpha * rx;
+  state_.y += state_.vy * dt + params_.alpha * ry;
+  state_.vx += params_.beta * rx / dt;
+  state_.vy += params_.beta * ry / dt;
+  state_.residual = 0.8 * state_.residual + 0.2 * std::hypot(rx, ry);
+  state_.time_usec = time_usec;
+  state_.samples++;
+}
+
+MotionPredictor::prediction MotionPredictor::predict(
+    const uint64_t target_usec) const {
+  prediction result{state_.x, state_.y, 0};
+  if (state_.samples < 2 || target_usec <= state_.time_usec ||
+      target_usec - state_.time_usec > params_.idle_reset_usec) {
+    return result;
+  }
+
+  const double horizon =
+      static_cast<double>(std::min<uint64_t>(target_usec - state_.time_usec,
+                                             params_.max_horizon_usec)) /
+      1e6;
+  // integral of a velocity decaying with time constant tau
+  const double tau =
+      std::max(static_cast<double>(params_.velocity_decay_usec) / 1e6, 1e-6);
+  const double travel = tau * (1.0 - std::exp(-horizon / tau));
+
+  result.x += state_.vx * travel;
+  result.y += state_.vy * travel;
+  result.confidence =
+      (1.0 - horizon * 1e6 / (params_.max_horizon_usec + 1.0)) /
+      (1.0 + state_.residual / std::max(params_.residual_scale, 1e-6));
+  result.confidence = std::clamp(result.confidence, 0.0, 1.0);
+  return result;
+}
+}  // namespace drmpp::input
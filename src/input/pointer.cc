@@ -17,7 +17,11 @@
 #include "input/pointer.h"
 
 #include <algorithm>
+#include <cstdlib>
+#include <filesystem>
 
+#include "cursor/xcursor_cache.h"
+#include "cursor/xcursor_theme.h"
 #include "input/default_cursor.h"
 #include "utils/utils.h"
 
@@ -32,12 +36,12 @@ Pointer::Pointer(const bool disable_cursor,
                  event_mask const& event_mask,
                  const int size)
     : disable_cursor_(disable_cursor),
+      size_(size > 0 ? static_cast<uint32_t>(size) : 24),
       event_mask_({.enabled = event_mask.enabled,
                    .all = event_mask.all,
                    .axis = event_mask.axis,
                    .buttons = event_mask.buttons,
                    .motion = event_mask.motion}) {
-  (void)size;
   LOG_DEBUG("Pointer");
 
   event_mask_.enabled = event_mask.enabled;
@@ -66,62 +70,101 @@ Pointer::Pointer(const bool disable_cursor,
 }
 
 Pointer::~Pointer() {
-  if (cursor_) {
-    for (auto& image : cursor_->images) {
-      image.reset();
-    }
-  }
+  cursor_.reset();
 }
 
 void Pointer::set_cursor(const uint32_t serial,
                          const char* cursor_name,
-                         const char* theme_name) const {
+                         const char* theme_name) {
   (void)serial;
-  (void)cursor_name;
-  (void)theme_name;
 
-  if (disable_cursor_) {
+  if (disable_cursor_ || cursor_name == nullptr) {
+    return;
+  }
+  const std::string theme =
+      theme_name == nullptr ? get_cursor_theme() : theme_name;
+  auto images =
+      XCursorCache::get_shared().get(theme, cursor_name, size_, scale_);
+  if (!images) {
+    LOG_WARN("Cursor not found in theme {}: {}", theme, cursor_name);
     return;
   }
-  /// TODO
+  cursor_name_ = cursor_name;
+  cursor_theme_ = theme;
+  cursor_ = std::move(images);
+  observers_.for_each([&](PointerObserver* observer) {
+    observer->notify_pointer_cursor(this, cursor_);
+  });
 }
 
-std::string Pointer::get_cursor_theme() {
-  std::string res;
-  utils::execute("gsettings get org.gnome.desktop.interface cursor-theme", res);
-  if (!res.empty()) {
-    // clean up string
-    std::string tmp = "\'\n";
-    for_each(tmp.begin(), tmp.end(), [&res](char n) {
-      res.erase(std::remove(res.begin(), res.end(), n), res.end());
-    });
+void Pointer::set_cursor_scale(const uint32_t serial, const double scale) {
+  if (scale <= 0 || scale == scale_) {
+    return;
+  }
+  scale_ = scale;
+  if (!cursor_name_.empty()) {
+    set_cursor(serial, cursor_name_.c_str(), cursor_theme_.c_str());
   }
-
-  return res;
 }
 
-std::vector<std::string> Pointer::get_available_cursors(
-    const char* theme_name) {
-  std::string theme = theme_name == nullptr ? get_cursor_theme() : theme_name;
-
-  std::ostringstream ss;
-  ss << "ls -1 /usr/share/icons/" << theme << "/cursors";
-
-  std::string res;
-  utils::execute(ss.str(), res);
+namespace {
+/**
+ * \brief Gets the first theme an index.theme inherits from.
+ *
+ * \param path The index.theme file.
+ * \return The theme name, or an empty string if none is listed.
+ */
+std::string read_inherited_theme(const std::filesystem::path& path) {
+  auto inherits = utils::read_ini_list(path, "Inherits");
+  return inherits.empty() ? std::string() : std::move(inherits.front());
+}
 
-  std::vector<std::string> cursor_list;
+/**
+ * \brief Gets the user's home directory.
+ *
+ * \return The value of HOME, or an empty path if not set.
+ */
+std::filesystem::path home_dir() {
+  const char* home = getenv("HOME");
+  return home ? std::filesystem::path(home) : std::filesystem::path();
+}
+}  // namespace
 
-  std::string line;
-  std::istringstream orig_stream(res);
-  while (std::getline(orig_stream, line)) {
-    if (!line.empty())
-      cursor_list.push_back(line);
-  }
+std::string Pointer::get_cursor_theme() {
+  static const std::string theme = [] {
+    if (const char* env = getenv("XCURSOR_THEME"); env && *env) {
+      return std::string(env);
+    }
 
-  std::sort(cursor_list.begin(), cursor_list.end());
+    const auto home = home_dir();
+    if (!home.empty()) {
+      // What GNOME and other GTK desktops mirror the cursor-theme setting to.
+      if (auto value = utils::read_ini_value(
+              home / ".config/gtk-3.0/settings.ini", "gtk-cursor-theme-name");
+          !value.empty()) {
+        return value;
+      }
+      if (auto value =
+              read_inherited_theme(home / ".icons/default/index.theme");
+          !value.empty()) {
+        return value;
+      }
+    }
+    if (auto value =
+            read_inherited_theme("/usr/share/icons/default/index.theme");
+        !value.empty()) {
+      return value;
+    }
+    return std::string("default");
+  }();
+  return theme;
+}
 
-  return cursor_list;
+std::vector<std::string> Pointer::get_available_cursors(
+    const char* theme_name) {
+  return XCursorTheme::load(theme_name == nullptr ? get_cursor_theme()
+                                                  : theme_name)
+      ->get_cursor_names();
 }
 
 void Pointer::set_event_mask(event_mask const& event_mask) {
@@ -132,39 +175,180 @@ void Pointer::set_event_mask(event_mask const& event_mask) {
   event_mask_.motion = event_mask.motion;
 }
 
-void Pointer::handle_pointer_button_event(libinput_event_pointer* ev) {
-  std::scoped_lock lock(observers_mutex_);
-  for (const auto observer : observers_) {
-    observer->notify_pointer_button(
-        this, 0, libinput_event_pointer_get_time(ev),
-        libinput_event_pointer_get_button(ev),
-        libinput_event_pointer_get_button_state(ev));
+void Pointer::set_output_size(const uint32_t width, const uint32_t height) {
+  output_.width = width;
+  output_.height = height;
+  predictor_.reset();
+}
+
+void Pointer::set_prediction(const bool enable,
+                             const MotionPredictor::params& params) {
+  predict_ = enable;
+  predictor_.set_params(params);
+  predictor_.reset();
+}
+
+MotionPredictor::prediction Pointer::predict(
+    const uint64_t target_usec) const {
+  if (!predict_) {
+    return {sx_, sy_, 0};
   }
+  if (const auto prediction = predictor_.predict(target_usec);
+      prediction.confidence > 0) {
+    return prediction;
+  }
+  return {sx_, sy_, 0};
 }
 
-void Pointer::handle_pointer_motion_event(libinput_event_pointer* ev) {
-  std::scoped_lock lock(observers_mutex_);
-  for (const auto observer : observers_) {
-    observer->notify_pointer_motion(this, libinput_event_pointer_get_time(ev),
-                                    libinput_event_pointer_get_dx(ev),
-                                    libinput_event_pointer_get_dy(ev));
+void Pointer::set_motion_coalescing(const bool enable,
+                                    const bool keep_history) {
+  if (!enable) {
+    flush_motion();
   }
+  coalesce_.enabled = enable;
+  coalesce_.keep_history = enable && keep_history;
+  motion_history_.clear();
 }
 
-void Pointer::handle_pointer_axis_event(libinput_event_pointer* ev) {
-  std::scoped_lock lock(observers_mutex_);
-  for (const auto observer : observers_) {
-    observer->notify_pointer_axis_source(
-        this, libinput_event_pointer_get_axis_source(ev));
+void Pointer::flush_motion() {
+  if (coalesce_.relative) {
+    observers_.for_each([&](PointerObserver* observer) {
+      observer->notify_pointer_motion(this, coalesce_.time, coalesce_.dx,
+                                      coalesce_.dy);
+    });
+  }
+  if (coalesce_.absolute) {
+    observers_.for_each([&](PointerObserver* observer) {
+      observer->notify_pointer_motion(this, coalesce_.abs_time, coalesce_.x,
+                                      coalesce_.y);
+    });
   }
+  coalesce_.relative = false;
+  coalesce_.dx = 0;
+  coalesce_.dy = 0;
+  coalesce_.absolute = false;
+  motion_history_.clear();
+}
+
+void Pointer::handle_pointer_button_event(libinput_event_pointer* ev) {
+  handle_pointer_button(libinput_event_pointer_get_time(ev),
+                        libinput_event_pointer_get_button(ev),
+                        libinput_event_pointer_get_button_state(ev));
+}
+
+void Pointer::handle_pointer_motion_event(libinput_event_pointer* ev) {
+  handle_pointer_motion(libinput_event_pointer_get_time(ev),
+                        libinput_event_pointer_get_dx(ev),
+                        libinput_event_pointer_get_dy(ev),
+                        libinput_event_pointer_get_time_usec(ev));
+}
+
+void Pointer::handle_pointer_axis_event(libinput_event_pointer* ev) {
+  handle_pointer_axis_source(libinput_event_pointer_get_axis_source(ev));
 }
 
 void Pointer::handle_pointer_motion_absolute_event(libinput_event_pointer* ev) {
-  std::scoped_lock lock(observers_mutex_);
-  for (const auto observer : observers_) {
-    observer->notify_pointer_motion(this, libinput_event_pointer_get_time(ev),
-                                    libinput_event_pointer_get_absolute_x(ev),
-                                    libinput_event_pointer_get_absolute_y(ev));
+  handle_pointer_motion_absolute(
+      libinput_event_pointer_get_time(ev),
+      libinput_event_pointer_get_absolute_x(ev),
+      libinput_event_pointer_get_absolute_y(ev),
+      libinput_event_pointer_get_absolute_x_transformed(ev, 1),
+      libinput_event_pointer_get_absolute_y_transformed(ev, 1),
+      libinput_event_pointer_get_time_usec(ev));
+}
+
+void Pointer::handle_pointer_button(const uint32_t time,
+                                    const uint32_t button,
+                                    const uint32_t state) {
+  if (event_mask_.enabled && (event_mask_.all || event_mask_.buttons)) {
+    return;
+  }
+  if (coalesce_.enabled) {
+    flush_motion();
+  }
+  observers_.for_each([&](PointerObserver* observer) {
+    observer->notify_pointer_button(this, 0, time, button, state);
+  });
+}
+
+void Pointer::handle_pointer_motion(const uint32_t time,
+                                    const double dx,
+                                    const double dy,
+                                    const uint64_t time_usec) {
+  if (event_mask_.enabled && (event_mask_.all || event_mask_.motion)) {
+    return;
+  }
+  sx_ += dx;
+  sy_ += dy;
+  if (output_.width && output_.height) {
+    sx_ = std::clamp(sx_, 0.0, output_.width - 1.0);
+    sy_ = std::clamp(sy_, 0.0, output_.height - 1.0);
   }
+  if (predict_) {
+    predictor_.update(time_usec ? time_usec : time * 1000ULL, sx_, sy_);
+  }
+
+  if (coalesce_.enabled) {
+    coalesce_.relative = true;
+    coalesce_.time = time;
+    coalesce_.dx += dx;
+    coalesce_.dy += dy;
+    if (coalesce_.keep_history) {
+      motion_history_.push_back({time, dx, dy, false});
+    }
+    return;
+  }
+
+  observers_.for_each([&](PointerObserver* observer) {
+    observer->notify_pointer_motion(this, time, dx, dy);
+  });
+}
+
+void Pointer::handle_pointer_axis_source(const uint32_t source) {
+  if (event_mask_.enabled && (event_mask_.all || event_mask_.axis)) {
+    return;
+  }
+  if (coalesce_.enabled) {
+    flush_motion();
+  }
+  observers_.for_each([&](PointerObserver* observer) {
+    observer->notify_pointer_axis_source(this, source);
+  });
+}
+
+void Pointer::handle_pointer_motion_absolute(const uint32_t time,
+                                             const double x,
+                                             const double y,
+                                             const double nx,
+                                             const double ny,
+                                             const uint64_t time_usec) {
+  if (event_mask_.enabled && (event_mask_.all || event_mask_.motion)) {
+    return;
+  }
+  if (output_.width && output_.height) {
+    sx_ = nx * output_.width;
+    sy_ = ny * output_.height;
+  } else {
+    sx_ = x;
+    sy_ = y;
+  }
+  if (predict_) {
+    predictor_.update(time_usec ? time_usec : time * 1000ULL, sx_, sy_);
+  }
+
+  if (coalesce_.enabled) {
+    coalesce_.absolute = true;
+    coalesce_.abs_time = time;
+    coalesce_.x = x;
+    coalesce_.y = y;
+    if (coalesce_.keep_history) {
+      motion_history_.push_back({time, x, y, true});
+    }
+    return;
+  }
+
+  observers_.for_each([&](PointerObserver* observer) {
+    observer->notify_pointer_motion(this, time, x, y);
+  });
 }
 }  // namespace drmpp::input
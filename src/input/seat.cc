@@ -17,16 +17,43 @@
 #include "input/seat.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <sstream>
+#include <string_view>
+
+#include <poll.h>
+#include <sys/eventfd.h>
 
 #include "linux/input-event-codes.h"
 
+#include "input/event_recorder.h"
+#include "input/gesture.h"
 #include "input/keyboard.h"
+#include "input/keymap_cache.h"
 #include "input/pointer.h"
+#include "input/tablet.h"
 #include "logging/logging.h"
 #include "utils/utils.h"
 
 namespace drmpp::input {
+namespace {
+/// libinput messages are truncated to this length
+constexpr size_t kLogBufferSize = 1024;
+/// messages printed per thread in each rate limit interval
+constexpr uint32_t kLogBurst = 32;
+constexpr auto kLogInterval = std::chrono::seconds(1);
+
+/**
+ * \brief Rate limit state of the thread libinput logs from.
+ */
+struct log_limiter {
+  std::chrono::steady_clock::time_point window; /**< Start of the interval */
+  uint32_t count;                               /**< Messages in interval */
+  uint64_t suppressed;                          /**< Messages dropped */
+};
+}  // namespace
+
 /**
  * @class Seat
  * @brief Represents a seat in a Wayland compositor.
@@ -38,51 +65,96 @@ namespace drmpp::input {
 Seat::Seat(const bool disable_cursor,
            const char* ignore_events,
            const char* seat_id)
-    : udev_(udev_new()), disable_cursor_(disable_cursor) {
-  li_ = libinput_udev_create_context(&interface_, nullptr, udev_);
+    : udev_(udev_new()), name_(seat_id), disable_cursor_(disable_cursor) {
+  li_ = libinput_udev_create_context(&interface_, this, udev_);
+  init_context(std::make_shared<KeymapCache>(), ignore_events);
+  libinput_udev_assign_seat(li_, seat_id);
+}
+
+Seat::Seat(std::shared_ptr<KeymapCache> keymap_cache,
+           const char* seat_id,
+           const bool disable_cursor,
+           const char* ignore_events)
+    : name_(seat_id), disable_cursor_(disable_cursor) {
+  li_ = libinput_path_create_context(&interface_, this);
+  init_context(keymap_cache ? std::move(keymap_cache)
+                            : std::make_shared<KeymapCache>(),
+               ignore_events);
+}
+
+void Seat::init_context(std::shared_ptr<KeymapCache> keymap_cache,
+                        const char* ignore_events) {
   libinput_log_set_priority(li_, LIBINPUT_LOG_PRIORITY_INFO);
-  libinput_log_set_handler(
-      li_, [](libinput* /* libinput */, const libinput_log_priority priority,
-              const char* format, va_list args) {
-        std::vector<char> buff(1024);
-        if (vsnprintf(buff.data(), 1024, format, args) < 0) {
-          LOG_ERROR("libinput log exceeded 1024 in length");
-          return;
-        }
-        std::string_view result(&buff[0], std::strlen(&buff[0]) - 1);
-        switch (priority) {
-          case LIBINPUT_LOG_PRIORITY_DEBUG:
-#if !defined(NDEBUG)
-            LOG_DEBUG("{}", result);
-#endif
-            break;
-          case LIBINPUT_LOG_PRIORITY_INFO:
-#if !defined(NDEBUG)
-            LOG_INFO("{}", result);
-#endif
-            break;
-          case LIBINPUT_LOG_PRIORITY_ERROR:
-            LOG_ERROR("{}", result);
-            break;
-          default:
-            break;
-        }
-      });
+  libinput_log_set_handler(li_, handle_log);
 
-  libinput_udev_assign_seat(li_, seat_id);
+  keymap_cache_ = std::move(keymap_cache);
+
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0) {
+    LOG_ERROR("epoll_create1: {}", std::strerror(errno));
+  } else {
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.ptr = this;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, libinput_get_fd(li_), &ev) < 0) {
+      LOG_ERROR("epoll_ctl: {}", std::strerror(errno));
+    }
+  }
 
   if (ignore_events) {
     set_event_mask(ignore_events);
   }
 }
 
+bool Seat::add_path_device(const char* dev_node) {
+  if (udev_) {
+    LOG_ERROR("{}: devices are assigned by udev", name_);
+    return false;
+  }
+  if (path_devices_.count(dev_node)) {
+    return true;
+  }
+  const auto dev = libinput_path_add_device(li_, dev_node);
+  if (!dev) {
+    LOG_ERROR("{}: failed to add {}", name_, dev_node);
+    return false;
+  }
+  path_devices_[dev_node] = libinput_device_ref(dev);
+  return true;
+}
+
+void Seat::remove_path_device(const char* dev_node) {
+  const auto it = path_devices_.find(dev_node);
+  if (it == path_devices_.end()) {
+    return;
+  }
+  // the device removed event is queued, and handled by the next dispatch
+  libinput_path_remove_device(it->second);
+  libinput_device_unref(it->second);
+  path_devices_.erase(it);
+}
+
 Seat::~Seat() {
+  // queued records are dropped, observers may already be gone
+  join_input_thread();
+  stop_input_thread();
+
   if (keyboards_ && !keyboards_->empty()) {
     for (auto& keyboard : *keyboards_) {
       keyboard.reset();
     }
   }
 
+  if (epoll_fd_ >= 0) {
+    close(epoll_fd_);
+  }
+  for (const auto& [dev, info] : devices_) {
+    libinput_device_set_user_data(dev, nullptr);
+    libinput_device_unref(dev);
+  }
+  for (const auto& [dev_node, dev] : path_devices_) {
+    libinput_device_unref(dev);
+  }
   if (li_) {
     libinput_unref(li_);
   }
@@ -91,9 +163,97 @@ Seat::~Seat() {
   }
 }
 
+void Seat::handle_log(libinput* li,
+                      const libinput_log_priority priority,
+                      const char* format,
+                      va_list args) {
+  // everything up to the rate limit is counted, nothing is allocated
+  const auto seat = static_cast<Seat*>(libinput_get_user_data(li));
+  bool print = false;
+  switch (priority) {
+    case LIBINPUT_LOG_PRIORITY_DEBUG:
+      if (seat) {
+        seat->log_debug_.fetch_add(1, std::memory_order_relaxed);
+      }
+#if !defined(NDEBUG)
+      print = true;
+#endif
+      break;
+    case LIBINPUT_LOG_PRIORITY_INFO:
+      if (seat) {
+        seat->log_info_.fetch_add(1, std::memory_order_relaxed);
+      }
+#if !defined(NDEBUG)
+      print = true;
+#endif
+      break;
+    case LIBINPUT_LOG_PRIORITY_ERROR:
+      if (seat) {
+        seat->log_error_.fetch_add(1, std::memory_order_relaxed);
+      }
+      print = true;
+      break;
+    default:
+      break;
+  }
+  if (!print) {
+    return;
+  }
+
+  thread_local log_limiter limiter{};
+  const auto now = std::chrono::steady_clock::now();
+  if (now - limiter.window >= kLogInterval) {
+    if (limiter.suppressed) {
+      LOG_WARN("libinput: {} messages suppressed", limiter.suppressed);
+    }
+    limiter = {.window = now, .count = 0, .suppressed = 0};
+  }
+  if (++limiter.count > kLogBurst) {
+    limiter.suppressed++;
+    if (seat) {
+      seat->log_suppressed_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return;
+  }
+
+  thread_local char buffer[kLogBufferSize];
+  const int res = vsnprintf(buffer, sizeof(buffer), format, args);
+  if (res < 0) {
+    return;
+  }
+  // longer messages are truncated, the trailing newline is dropped
+  auto length = std::min(static_cast<size_t>(res), sizeof(buffer) - 1);
+  while (length > 0 && buffer[length - 1] == '\n') {
+    length--;
+  }
+  if (length == 0) {
+    return;
+  }
+  const std::string_view message(buffer, length);
+  switch (priority) {
+    case LIBINPUT_LOG_PRIORITY_DEBUG:
+      LOG_DEBUG("{}", message);
+      break;
+    case LIBINPUT_LOG_PRIORITY_INFO:
+      LOG_INFO("{}", message);
+      break;
+    default:
+      LOG_ERROR("{}", message);
+      break;
+  }
+}
+
+Seat::log_stats Seat::get_log_stats() const {
+  return {
+      .debug = log_debug_.load(std::memory_order_relaxed),
+      .info = log_info_.load(std::memory_order_relaxed),
+      .error = log_error_.load(std::memory_order_relaxed),
+      .suppressed = log_suppressed_.load(std::memory_order_relaxed),
+  };
+}
+
 void Seat::register_observer(SeatObserver* observer, void* user_data) {
-  std::scoped_lock lock(observers_mutex_);
-  observers_.push_back(observer);
+  observers_.add(observer);
 
   if (user_data) {
     user_data_ = user_data;
@@ -101,169 +261,1016 @@ void Seat::register_observer(SeatObserver* observer, void* user_data) {
 }
 
 void Seat::unregister_observer(SeatObserver* observer) {
-  std::scoped_lock lock(observers_mutex_);
   observers_.remove(observer);
 }
 
 bool Seat::run_once() {
+  if (input_thread_.joinable()) {
+    drain_input();
+    return true;
+  }
+  poll_fds(0);
   libinput_dispatch(li_);
 
   if (const auto ev = libinput_get_event(li_)) {
-    const auto type = libinput_event_get_type(ev);
-    DLOG_TRACE("Event: {}", static_cast<int>(type));
+    handle_event(ev);
+    libinput_event_destroy(ev);
+    events_handled_++;
+  }
 
-    if (capabilities_init_ && type != LIBINPUT_EVENT_DEVICE_ADDED) {
-      capabilities_init_ = false;
-      std::scoped_lock lock(observers_mutex_);
-      for (const auto observer : observers_) {
-        observer->notify_seat_capabilities(this, capabilities_);
-      }
+  return true;
+}
+
+size_t Seat::dispatch_all(const std::chrono::microseconds budget) {
+  if (input_thread_.joinable()) {
+    return drain_input(0, budget);
+  }
+  libinput_dispatch(li_);
+
+  const auto start = std::chrono::steady_clock::now();
+  size_t count = 0;
+  while (const auto ev = libinput_get_event(li_)) {
+    handle_event(ev);
+    libinput_event_destroy(ev);
+    count++;
+
+    // the budget is checked per event, so at least one event is handled
+    if (budget.count() > 0 &&
+        std::chrono::steady_clock::now() - start >= budget) {
+      break;
+    }
+  }
+
+  last_dispatch_count_ = count;
+  events_handled_ += count;
+  return count;
+}
+
+int Seat::wait_and_dispatch(const int timeout_ms) {
+  if (input_thread_.joinable()) {
+    const bool queued = input_ring_->size() != 0;
+    // poll_fds already serviced the repeat timers that fired
+    if (poll_fds(queued ? 0 : timeout_ms) < 0) {
+      return -1;
     }
+    return static_cast<int>(drain_ring(0, {}));
+  }
+
+  // events queued by libinput itself (e.g. initial device added events) do
+  // not make the fd readable, so only block when the queue is empty
+  libinput_dispatch(li_);
+  const bool queued = libinput_next_event_type(li_) != LIBINPUT_EVENT_NONE;
+  const int res = poll_fds(queued ? 0 : timeout_ms);
+  if (res < 0) {
+    return -1;
+  }
+  if (res == 0 && !queued) {
+    return 0;
+  }
+  return static_cast<int>(dispatch_all());
+}
+
+int Seat::poll_fds(const int timeout_ms) const {
+  epoll_event events[8];
+  const int res = epoll_wait(epoll_fd_, events, 8, timeout_ms);
+  if (res < 0) {
+    if (errno == EINTR) {
+      return 0;
+    }
+    LOG_ERROR("epoll_wait: {}", std::strerror(errno));
+    return -1;
+  }
+  for (int i = 0; i < res; i++) {
+    // everything other than the libinput fd is a key repeat timer
+    if (events[i].data.ptr != this) {
+      static_cast<Keyboard*>(events[i].data.ptr)->handle_repeat();
+    }
+  }
+  return res;
+}
+
+bool Seat::attach_to_epoll(const int epoll_fd) {
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.ptr = this;
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, epoll_fd_, &ev) < 0) {
+    LOG_ERROR("epoll_ctl: {}", std::strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+void Seat::detach_from_epoll(const int epoll_fd) const {
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, epoll_fd_, nullptr);
+}
+
+bool Seat::filter_event(libinput_event* ev) {
+  const auto type = libinput_event_get_type(ev);
+  if (type == LIBINPUT_EVENT_DEVICE_ADDED) {
     const auto dev = libinput_event_get_device(ev);
+    apply_send_events(dev, add_device(dev).disabled);
+    return false;
+  }
+  if (is_masked(type)) {
+    events_masked_++;
+    return true;
+  }
+  return false;
+}
 
-    switch (type) {
-      case LIBINPUT_EVENT_DEVICE_ADDED: {
-        const auto name = libinput_device_get_name(dev);
+Seat::device_info& Seat::add_device(libinput_device* dev) {
+  // ids wrap after 32767 replugs, skip any still in use. The top bit is
+  // left to replayed devices.
+  do {
+    last_device_id_ =
+        static_cast<uint16_t>((last_device_id_ + 1) & ~kReplayDeviceBit);
+  } while (last_device_id_ == 0 ||
+           std::any_of(devices_.begin(), devices_.end(),
+                       [this](const auto& entry) {
+                         return entry.second.id == last_device_id_;
+                       }));
+  auto& info = devices_[libinput_device_ref(dev)];
+  info = {.id = last_device_id_, .disabled = false};
+  libinput_device_set_user_data(dev, &info);
+  return info;
+}
 
-        if (libinput_device_has_capability(dev, LIBINPUT_DEVICE_CAP_SWITCH)) {
-          capabilities_ |= SeatObserver::SEAT_CAPABILITIES_SWITCH;
-          DLOG_TRACE("Added Switch: {}", name);
-        }
-        if (libinput_device_has_capability(dev, LIBINPUT_DEVICE_CAP_GESTURE)) {
-          capabilities_ |= SeatObserver::SEAT_CAPABILITIES_GESTURE;
-          DLOG_TRACE("Added Gesture: {}", name);
-        }
-        if (libinput_device_has_capability(dev, LIBINPUT_DEVICE_CAP_TOUCH)) {
-          if (!touch_) {
-            touch_ = std::make_shared<Touch>(event_mask_.touch);
-          }
-          capabilities_ |= SeatObserver::SEAT_CAPABILITIES_TOUCH;
-          DLOG_TRACE("Added Touch: {}", name);
-        }
-        if (libinput_device_has_capability(dev, LIBINPUT_DEVICE_CAP_POINTER)) {
-          if (libinput_device_pointer_has_button(dev, BTN_LEFT)) {
-            if (!pointer_) {
-              pointer_ = std::make_shared<Pointer>(disable_cursor_,
-                                                   event_mask_.pointer);
-            }
-            capabilities_ |= SeatObserver::SEAT_CAPABILITIES_POINTER;
-            DLOG_TRACE("Added Pointer: {}", name);
-          }
-        }
-        if (libinput_device_has_capability(dev, LIBINPUT_DEVICE_CAP_KEYBOARD)) {
-          if (libinput_device_keyboard_has_key(dev, KEY_ENTER) ||
-              libinput_device_keyboard_has_key(dev, KEY_KPENTER)) {
-            const auto udev_device = libinput_device_get_udev_device(dev);
-            if (!keyboards_) {
-              keyboards_ =
-                  std::make_shared<std::vector<std::unique_ptr<Keyboard>>>();
-            }
-            keyboards_->emplace_back(std::make_unique<Keyboard>(
-                event_mask_.keyboard,
-                udev_device_get_property_value(udev_device, "XKBMODEL"),
-                udev_device_get_property_value(udev_device, "XKBLAYOUT"),
-                udev_device_get_property_value(udev_device, "XKBVARIANT"),
-                udev_device_get_property_value(udev_device, "XKBOPTIONS")));
-            udev_device_unref(udev_device);
-            capabilities_ |= SeatObserver::SEAT_CAPABILITIES_KEYBOARD;
-            DLOG_TRACE("Added Keyboard: {}", name);
-          }
-        }
-        if (libinput_device_has_capability(dev,
-                                           LIBINPUT_DEVICE_CAP_TABLET_PAD)) {
-          capabilities_ |= SeatObserver::SEAT_CAPABILITIES_TABLET_PAD;
-          DLOG_TRACE("Added Tablet Pad: {}", name);
-        }
-        if (libinput_device_has_capability(dev,
-                                           LIBINPUT_DEVICE_CAP_TABLET_TOOL)) {
-          capabilities_ |= SeatObserver::SEAT_CAPABILITIES_TABLET_TOOL;
-          DLOG_TRACE("Added Tablet Tool: {}", name);
-        }
-        break;
+void Seat::release_device(libinput_device* dev) {
+  if (devices_.erase(dev)) {
+    libinput_device_set_user_data(dev, nullptr);
+    libinput_device_unref(dev);
+  }
+}
+
+bool Seat::is_masked(const libinput_event_type type) const {
+  uint32_t mask;
+  switch (type) {
+    case LIBINPUT_EVENT_KEYBOARD_KEY:
+      mask = MASKED_KEYBOARD;
+      break;
+    case LIBINPUT_EVENT_POINTER_BUTTON:
+      mask = MASKED_POINTER_BUTTON;
+      break;
+    case LIBINPUT_EVENT_POINTER_MOTION:
+    case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+      mask = MASKED_POINTER_MOTION;
+      break;
+    case LIBINPUT_EVENT_POINTER_AXIS:
+      mask = MASKED_POINTER_AXIS;
+      break;
+    case LIBINPUT_EVENT_TOUCH_DOWN:
+    case LIBINPUT_EVENT_TOUCH_UP:
+    case LIBINPUT_EVENT_TOUCH_MOTION:
+    case LIBINPUT_EVENT_TOUCH_CANCEL:
+    case LIBINPUT_EVENT_TOUCH_FRAME:
+      mask = MASKED_TOUCH;
+      break;
+    case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
+    case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
+    case LIBINPUT_EVENT_TABLET_TOOL_TIP:
+    case LIBINPUT_EVENT_TABLET_TOOL_BUTTON:
+      mask = MASKED_TABLET;
+      break;
+    case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
+    case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
+    case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+    case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+    case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+    case LIBINPUT_EVENT_GESTURE_PINCH_END:
+    case LIBINPUT_EVENT_GESTURE_HOLD_BEGIN:
+    case LIBINPUT_EVENT_GESTURE_HOLD_END:
+      mask = MASKED_GESTURE;
+      break;
+    default:
+      return false;
+  }
+  return (masked_events_.load(std::memory_order_relaxed) & mask) != 0;
+}
+
+void Seat::update_masked_events() {
+  uint32_t masked = 0;
+  if (event_mask_.keyboard.enabled && event_mask_.keyboard.all) {
+    masked |= MASKED_KEYBOARD;
+  }
+  if (const auto& pointer = event_mask_.pointer; pointer.enabled) {
+    if (pointer.all || pointer.buttons) {
+      masked |= MASKED_POINTER_BUTTON;
+    }
+    if (pointer.all || pointer.motion) {
+      masked |= MASKED_POINTER_MOTION;
+    }
+    if (pointer.all || pointer.axis) {
+      masked |= MASKED_POINTER_AXIS;
+    }
+  }
+  if (event_mask_.touch.enabled && event_mask_.touch.all) {
+    masked |= MASKED_TOUCH;
+  }
+  if (event_mask_.tablet.enabled && event_mask_.tablet.all) {
+    masked |= MASKED_TABLET;
+  }
+  if (event_mask_.gesture.enabled && event_mask_.gesture.all) {
+    masked |= MASKED_GESTURE;
+  }
+  masked_events_ = masked;
+  refresh_send_events();
+}
+
+void Seat::refresh_send_events() {
+  if (input_thread_.joinable()) {
+    // libinput belongs to the input thread while it runs
+    send_events_dirty_ = true;
+    constexpr uint64_t one = 1;
+    if (write(input_wake_fd_, &one, sizeof(one)) < 0) {
+      LOG_ERROR("eventfd write: {}", std::strerror(errno));
+    }
+    return;
+  }
+  for (auto& [dev, info] : devices_) {
+    apply_send_events(dev, info.disabled);
+  }
+}
+
+void Seat::apply_send_events(libinput_device* dev, bool& disabled) const {
+  constexpr uint32_t kPointerMasks =
+      MASKED_POINTER_BUTTON | MASKED_POINTER_MOTION | MASKED_POINTER_AXIS;
+  const auto masked = masked_events_.load();
+  uint32_t masked_caps = 0;
+  if (masked & MASKED_KEYBOARD) {
+    masked_caps |= SeatObserver::SEAT_CAPABILITIES_KEYBOARD;
+  }
+  if ((masked & kPointerMasks) == kPointerMasks) {
+    masked_caps |= SeatObserver::SEAT_CAPABILITIES_POINTER;
+  }
+  if (masked & MASKED_TOUCH) {
+    masked_caps |= SeatObserver::SEAT_CAPABILITIES_TOUCH;
+  }
+  if (masked & MASKED_TABLET) {
+    masked_caps |= SeatObserver::SEAT_CAPABILITIES_TABLET_TOOL;
+  }
+  if (masked & MASKED_GESTURE) {
+    masked_caps |= SeatObserver::SEAT_CAPABILITIES_GESTURE;
+  }
+
+  // only devices the seat disabled itself are ever re-enabled
+  const auto caps = get_device_capabilities(dev);
+  const bool disable =
+      disable_masked_devices_ && caps != 0 && (caps & ~masked_caps) == 0;
+  if (disable == disabled) {
+    return;
+  }
+  const auto mode = disable ? LIBINPUT_CONFIG_SEND_EVENTS_DISABLED
+                            : LIBINPUT_CONFIG_SEND_EVENTS_ENABLED;
+  if (libinput_device_config_send_events_set_mode(dev, mode) !=
+      LIBINPUT_CONFIG_STATUS_SUCCESS) {
+    LOG_WARN("{}: failed to set send events mode",
+             libinput_device_get_name(dev));
+    return;
+  }
+  disabled = disable;
+  DLOG_DEBUG("{}: {}", libinput_device_get_name(dev),
+             disable ? "disabled" : "enabled");
+}
+
+void Seat::set_disable_masked_devices(const bool enable) {
+  disable_masked_devices_ = enable;
+  refresh_send_events();
+}
+
+void Seat::handle_event(libinput_event* ev) {
+  if (filter_event(ev)) {
+    return;
+  }
+  const auto record = decode_event(ev);
+  if (recorder_) {
+    recorder_->append(record);
+  }
+  const auto dev = libinput_event_get_device(ev);
+  dispatch_record(record, dev);
+  if (record.type == LIBINPUT_EVENT_DEVICE_REMOVED) {
+    release_device(dev);
+  }
+}
+
+EventRecord Seat::decode_event(libinput_event* ev) {
+  const auto type = libinput_event_get_type(ev);
+  DLOG_TRACE("Event: {}", static_cast<int>(type));
+
+  const auto dev = libinput_event_get_device(ev);
+  EventRecord record{};
+  record.type = type;
+  record.slot = -1;
+  record.seat_slot = -1;
+  if (const auto info =
+          static_cast<device_info*>(libinput_device_get_user_data(dev))) {
+    record.device = info->id;
+  }
+
+  switch (type) {
+    case LIBINPUT_EVENT_DEVICE_ADDED:
+    case LIBINPUT_EVENT_DEVICE_REMOVED:
+      record.caps = get_device_capabilities(dev);
+      break;
+    case LIBINPUT_EVENT_KEYBOARD_KEY: {
+      const auto key_event = libinput_event_get_keyboard_event(ev);
+      record.time_usec = libinput_event_keyboard_get_time_usec(key_event);
+      record.code = libinput_event_keyboard_get_key(key_event);
+      record.state = libinput_event_keyboard_get_key_state(key_event);
+      break;
+    }
+    case LIBINPUT_EVENT_POINTER_BUTTON: {
+      const auto pointer_event = libinput_event_get_pointer_event(ev);
+      record.time_usec = libinput_event_pointer_get_time_usec(pointer_event);
+      record.code = libinput_event_pointer_get_button(pointer_event);
+      record.state = libinput_event_pointer_get_button_state(pointer_event);
+      break;
+    }
+    case LIBINPUT_EVENT_POINTER_MOTION: {
+      const auto pointer_event = libinput_event_get_pointer_event(ev);
+      record.time_usec = libinput_event_pointer_get_time_usec(pointer_event);
+      record.x = libinput_event_pointer_get_dx(pointer_event);
+      record.y = libinput_event_pointer_get_dy(pointer_event);
+      break;
+    }
+    case LIBINPUT_EVENT_POINTER_AXIS: {
+      const auto pointer_event = libinput_event_get_pointer_event(ev);
+      record.time_usec = libinput_event_pointer_get_time_usec(pointer_event);
+      record.code = libinput_event_pointer_get_axis_source(pointer_event);
+      break;
+    }
+    case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE: {
+      const auto pointer_event = libinput_event_get_pointer_event(ev);
+      record.time_usec = libinput_event_pointer_get_time_usec(pointer_event);
+      record.x = libinput_event_pointer_get_absolute_x(pointer_event);
+      record.y = libinput_event_pointer_get_absolute_y(pointer_event);
+      record.nx =
+          libinput_event_pointer_get_absolute_x_transformed(pointer_event, 1);
+      record.ny =
+          libinput_event_pointer_get_absolute_y_transformed(pointer_event, 1);
+      break;
+    }
+    case LIBINPUT_EVENT_TOUCH_DOWN:
+    case LIBINPUT_EVENT_TOUCH_MOTION: {
+      const auto touch_event = libinput_event_get_touch_event(ev);
+      record.time_usec = libinput_event_touch_get_time_usec(touch_event);
+      record.slot = libinput_event_touch_get_slot(touch_event);
+      record.seat_slot = libinput_event_touch_get_seat_slot(touch_event);
+      record.x = libinput_event_touch_get_x(touch_event);
+      record.y = libinput_event_touch_get_y(touch_event);
+      record.nx = libinput_event_touch_get_x_transformed(touch_event, 1);
+      record.ny = libinput_event_touch_get_y_transformed(touch_event, 1);
+      break;
+    }
+    case LIBINPUT_EVENT_TOUCH_UP: {
+      const auto touch_event = libinput_event_get_touch_event(ev);
+      record.time_usec = libinput_event_touch_get_time_usec(touch_event);
+      record.slot = libinput_event_touch_get_slot(touch_event);
+      record.seat_slot = libinput_event_touch_get_seat_slot(touch_event);
+      break;
+    }
+    case LIBINPUT_EVENT_TOUCH_FRAME:
+    case LIBINPUT_EVENT_TOUCH_CANCEL:
+      record.time_usec = libinput_event_touch_get_time_usec(
+          libinput_event_get_touch_event(ev));
+      break;
+    case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
+    case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
+    case LIBINPUT_EVENT_TABLET_TOOL_TIP: {
+      // one event carries every axis that changed in the frame
+      const auto tablet_event = libinput_event_get_tablet_tool_event(ev);
+      const auto tool = libinput_event_tablet_tool_get_tool(tablet_event);
+      record.time_usec = libinput_event_tablet_tool_get_time_usec(tablet_event);
+      record.code = libinput_tablet_tool_get_type(tool);
+      if (type == LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY) {
+        record.state =
+            libinput_event_tablet_tool_get_proximity_state(tablet_event);
+      } else {
+        record.state = libinput_event_tablet_tool_get_tip_state(tablet_event);
       }
-      case LIBINPUT_EVENT_DEVICE_REMOVED: {
-        libinput_device* device = libinput_event_get_device(ev);
-        const auto name = libinput_device_get_name(device);
+      record.x = libinput_event_tablet_tool_get_x(tablet_event);
+      record.y = libinput_event_tablet_tool_get_y(tablet_event);
+      record.nx = static_cast<float>(
+          libinput_event_tablet_tool_get_x_transformed(tablet_event, 1));
+      record.ny = static_cast<float>(
+          libinput_event_tablet_tool_get_y_transformed(tablet_event, 1));
+      record.pressure = static_cast<float>(
+          libinput_event_tablet_tool_get_pressure(tablet_event));
+      record.tilt_x = static_cast<float>(
+          libinput_event_tablet_tool_get_tilt_x(tablet_event));
+      record.tilt_y = static_cast<float>(
+          libinput_event_tablet_tool_get_tilt_y(tablet_event));
+      break;
+    }
+    case LIBINPUT_EVENT_TABLET_TOOL_BUTTON: {
+      const auto tablet_event = libinput_event_get_tablet_tool_event(ev);
+      record.time_usec = libinput_event_tablet_tool_get_time_usec(tablet_event);
+      record.code = libinput_event_tablet_tool_get_button(tablet_event);
+      record.state = libinput_event_tablet_tool_get_button_state(tablet_event);
+      break;
+    }
+    case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
+    case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
+    case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+    case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+    case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+    case LIBINPUT_EVENT_GESTURE_PINCH_END:
+    case LIBINPUT_EVENT_GESTURE_HOLD_BEGIN:
+    case LIBINPUT_EVENT_GESTURE_HOLD_END: {
+      const auto gesture_event = libinput_event_get_gesture_event(ev);
+      record.time_usec = libinput_event_gesture_get_time_usec(gesture_event);
+      record.code = libinput_event_gesture_get_finger_count(gesture_event);
+      if (type == LIBINPUT_EVENT_GESTURE_SWIPE_END ||
+          type == LIBINPUT_EVENT_GESTURE_PINCH_END ||
+          type == LIBINPUT_EVENT_GESTURE_HOLD_END) {
+        record.state = libinput_event_gesture_get_cancelled(gesture_event);
+      } else if (type == LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE ||
+                 type == LIBINPUT_EVENT_GESTURE_PINCH_UPDATE) {
+        record.x = libinput_event_gesture_get_dx(gesture_event);
+        record.y = libinput_event_gesture_get_dy(gesture_event);
+      }
+      if (type == LIBINPUT_EVENT_GESTURE_PINCH_UPDATE) {
+        record.nx =
+            static_cast<float>(libinput_event_gesture_get_scale(gesture_event));
+        record.ny = static_cast<float>(
+            libinput_event_gesture_get_angle_delta(gesture_event));
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  return record;
+}
 
-        if (libinput_device_has_capability(device, LIBINPUT_DEVICE_CAP_TOUCH)) {
-          DLOG_TRACE("{}: Touch Removed", name);
-        }
-        if (libinput_device_has_capability(device,
-                                           LIBINPUT_DEVICE_CAP_SWITCH)) {
-          DLOG_TRACE("{}: Switch Removed", name);
+void Seat::handle_record(const EventRecord& record) {
+  if (is_masked(static_cast<libinput_event_type>(record.type))) {
+    events_masked_++;
+    return;
+  }
+  // recorded ids are moved out of the range of live devices, so a replayed
+  // key never reaches a real keyboard
+  auto replayed = record;
+  if (replayed.device != 0) {
+    replayed.device |= kReplayDeviceBit;
+  }
+  dispatch_record(replayed, nullptr);
+}
+
+void Seat::dispatch_record(const EventRecord& record, libinput_device* dev) {
+  const auto type = static_cast<libinput_event_type>(record.type);
+  if (capabilities_init_ && type != LIBINPUT_EVENT_DEVICE_ADDED) {
+    capabilities_init_ = false;
+    notify_capabilities();
+  }
+
+  // libinput event times in milliseconds are the truncated microseconds
+  const auto time = static_cast<uint32_t>(record.time_usec / 1000);
+  if (record.time_usec != 0) {
+    input_token_.time_usec = record.time_usec;
+    input_token_.sequence++;
+  }
+
+  switch (type) {
+    case LIBINPUT_EVENT_DEVICE_ADDED:
+      handle_device_added(record, dev);
+      break;
+    case LIBINPUT_EVENT_DEVICE_REMOVED:
+      handle_device_removed(record, dev);
+      break;
+    case LIBINPUT_EVENT_KEYBOARD_KEY: {
+      const auto state = static_cast<libinput_key_state>(record.state);
+      if (record.device != 0) {
+        // only the keyboard of the device sees the key
+        if (const auto it = device_states_.find(record.device);
+            it != device_states_.end() && it->second.keyboard) {
+          it->second.keyboard->handle_key(time, record.code, state);
         }
-        if (libinput_device_has_capability(device,
-                                           LIBINPUT_DEVICE_CAP_GESTURE)) {
-          DLOG_TRACE("{}: Gesture Removed", name);
+      } else if (keyboards_) {
+        for (const auto& keyboard : *keyboards_) {
+          keyboard->handle_key(time, record.code, state);
         }
-        if (libinput_device_has_capability(device,
-                                           LIBINPUT_DEVICE_CAP_POINTER)) {
-          DLOG_TRACE("{}: Pointer Removed", name);
+      }
+      break;
+    }
+    case LIBINPUT_EVENT_POINTER_BUTTON:
+      if (pointer_) {
+        pointer_->handle_pointer_button(time, record.code, record.state);
+      }
+      break;
+    case LIBINPUT_EVENT_POINTER_MOTION:
+      if (pointer_) {
+        pointer_->handle_pointer_motion(time, record.x, record.y,
+                                        record.time_usec);
+      }
+      break;
+    case LIBINPUT_EVENT_POINTER_AXIS:
+      if (pointer_) {
+        pointer_->handle_pointer_axis_source(record.code);
+      }
+      break;
+    case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+      if (pointer_) {
+        pointer_->handle_pointer_motion_absolute(time, record.x, record.y,
+                                                 record.nx, record.ny,
+                                                 record.time_usec);
+      }
+      break;
+    case LIBINPUT_EVENT_TOUCH_UP:
+      if (touch_) {
+        touch_->handle_touch_up(time, record.slot, record.seat_slot);
+      }
+      break;
+    case LIBINPUT_EVENT_TOUCH_DOWN:
+      if (touch_) {
+        touch_->handle_touch_down(time, record.slot, record.seat_slot,
+                                  record.x, record.y, record.nx, record.ny,
+                                  record.time_usec);
+      }
+      break;
+    case LIBINPUT_EVENT_TOUCH_FRAME:
+      if (touch_) {
+        touch_->handle_touch_frame(time);
+      }
+      break;
+    case LIBINPUT_EVENT_TOUCH_CANCEL:
+      if (touch_) {
+        touch_->handle_touch_cancel(time);
+      }
+      break;
+    case LIBINPUT_EVENT_TOUCH_MOTION:
+      if (touch_) {
+        touch_->handle_touch_motion(time, record.slot, record.seat_slot,
+                                    record.x, record.y, record.nx, record.ny,
+                                    record.time_usec);
+      }
+      break;
+    case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
+      if (tablet_) {
+        tablet_->handle_tool_axis(time, record.x, record.y, record.nx,
+                                  record.ny, record.pressure, record.tilt_x,
+                                  record.tilt_y, record.time_usec);
+      }
+      break;
+    case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
+      if (tablet_) {
+        tablet_->handle_tool_proximity(
+            time, record.code,
+            record.state == LIBINPUT_TABLET_TOOL_PROXIMITY_STATE_IN, record.x,
+            record.y, record.nx, record.ny, record.time_usec);
+      }
+      break;
+    case LIBINPUT_EVENT_TABLET_TOOL_TIP:
+      if (tablet_) {
+        tablet_->handle_tool_tip(
+            time, record.state == LIBINPUT_TABLET_TOOL_TIP_DOWN, record.x,
+            record.y, record.nx, record.ny, record.pressure, record.time_usec);
+      }
+      break;
+    case LIBINPUT_EVENT_TABLET_TOOL_BUTTON:
+      if (tablet_) {
+        tablet_->handle_tool_button(time, record.code, record.state);
+      }
+      break;
+    case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
+      if (gesture_) {
+        gesture_->handle_swipe_begin(time, record.code);
+      }
+      break;
+    case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
+      if (gesture_) {
+        gesture_->handle_swipe_update(time, record.code, record.x, record.y);
+      }
+      break;
+    case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+      if (gesture_) {
+        gesture_->handle_swipe_end(time, record.code, record.state != 0);
+      }
+      break;
+    case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+      if (gesture_) {
+        gesture_->handle_pinch_begin(time, record.code);
+      }
+      break;
+    case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+      if (gesture_) {
+        gesture_->handle_pinch_update(time, record.code, record.x, record.y,
+                                      record.nx, record.ny);
+      }
+      break;
+    case LIBINPUT_EVENT_GESTURE_PINCH_END:
+      if (gesture_) {
+        gesture_->handle_pinch_end(time, record.code, record.state != 0);
+      }
+      break;
+    case LIBINPUT_EVENT_GESTURE_HOLD_BEGIN:
+      if (gesture_) {
+        gesture_->handle_hold_begin(time, record.code);
+      }
+      break;
+    case LIBINPUT_EVENT_GESTURE_HOLD_END:
+      if (gesture_) {
+        gesture_->handle_hold_end(time, record.code, record.state != 0);
+      }
+      break;
+    default:
+      // counted rather than logged, this runs at the device event rate
+      events_unhandled_++;
+      break;
+  }
+}
+
+uint32_t Seat::get_device_capabilities(libinput_device* dev) {
+  uint32_t caps = 0;
+  if (libinput_device_has_capability(dev, LIBINPUT_DEVICE_CAP_SWITCH)) {
+    caps |= SeatObserver::SEAT_CAPABILITIES_SWITCH;
+  }
+  if (libinput_device_has_capability(dev, LIBINPUT_DEVICE_CAP_GESTURE)) {
+    caps |= SeatObserver::SEAT_CAPABILITIES_GESTURE;
+  }
+  if (libinput_device_has_capability(dev, LIBINPUT_DEVICE_CAP_TOUCH)) {
+    caps |= SeatObserver::SEAT_CAPABILITIES_TOUCH;
+  }
+  if (libinput_device_has_capability(dev, LIBINPUT_DEVICE_CAP_POINTER) &&
+      libinput_device_pointer_has_button(dev, BTN_LEFT)) {
+    caps |= SeatObserver::SEAT_CAPABILITIES_POINTER;
+  }
+  if (libinput_device_has_capability(dev, LIBINPUT_DEVICE_CAP_KEYBOARD) &&
+      (libinput_device_keyboard_has_key(dev, KEY_ENTER) ||
+       libinput_device_keyboard_has_key(dev, KEY_KPENTER))) {
+    caps |= SeatObserver::SEAT_CAPABILITIES_KEYBOARD;
+  }
+  if (libinput_device_has_capability(dev, LIBINPUT_DEVICE_CAP_TABLET_PAD)) {
+    caps |= SeatObserver::SEAT_CAPABILITIES_TABLET_PAD;
+  }
+  if (libinput_device_has_capability(dev, LIBINPUT_DEVICE_CAP_TABLET_TOOL)) {
+    caps |= SeatObserver::SEAT_CAPABILITIES_TABLET_TOOL;
+  }
+  return caps;
+}
+
+void Seat::handle_device_added(const EventRecord& record,
+                               libinput_device* dev) {
+  const auto caps = record.caps;
+  const auto name = dev ? libinput_device_get_name(dev) : "replay";
+  Keyboard* keyboard_handler = nullptr;
+
+  if (caps & SeatObserver::SEAT_CAPABILITIES_SWITCH) {
+    DLOG_TRACE("Added Switch: {}", name);
+  }
+  if (caps & SeatObserver::SEAT_CAPABILITIES_GESTURE) {
+    if (!gesture_) {
+      gesture_ = std::make_shared<Gesture>(event_mask_.gesture);
+      gesture_->set_motion_coalescing(coalesce_.enabled);
+    }
+    DLOG_TRACE("Added Gesture: {}", name);
+  }
+  if (caps & SeatObserver::SEAT_CAPABILITIES_TOUCH) {
+    if (!touch_) {
+      touch_ = std::make_shared<Touch>(event_mask_.touch);
+      touch_->set_motion_coalescing(coalesce_.enabled, coalesce_.keep_history);
+      touch_->set_output_size(output_.width, output_.height);
+    }
+    DLOG_TRACE("Added Touch: {}", name);
+  }
+  if (caps & SeatObserver::SEAT_CAPABILITIES_POINTER) {
+    if (!pointer_) {
+      pointer_ =
+          std::make_shared<Pointer>(disable_cursor_, event_mask_.pointer);
+      pointer_->set_motion_coalescing(coalesce_.enabled,
+                                      coalesce_.keep_history);
+      pointer_->set_output_size(output_.width, output_.height);
+    }
+    DLOG_TRACE("Added Pointer: {}", name);
+  }
+  if (caps & SeatObserver::SEAT_CAPABILITIES_KEYBOARD) {
+    if (!keyboards_) {
+      keyboards_ = std::make_shared<std::vector<std::unique_ptr<Keyboard>>>();
+    }
+    // devices from the input thread carry their properties in the pending
+    // map, replayed devices have none and use the default keymap
+    xkb_names names{};
+    if (dev) {
+      names = get_xkb_names(dev);
+    } else if (record.device != 0) {
+      std::scoped_lock lock(pending_names_mutex_);
+      if (const auto it = pending_names_.find(record.device);
+          it != pending_names_.end()) {
+        names = std::move(it->second);
+        pending_names_.erase(it);
+      }
+    }
+    const auto c_str = [](const std::string& value) -> const char* {
+      return value.empty() ? nullptr : value.c_str();
+    };
+    const auto& keyboard = keyboards_->emplace_back(std::make_unique<Keyboard>(
+        event_mask_.keyboard, keymap_cache_, c_str(names.model),
+        c_str(names.layout), c_str(names.variant), c_str(names.options)));
+    epoll_event repeat_ev{};
+    repeat_ev.events = EPOLLIN;
+    repeat_ev.data.ptr = keyboard.get();
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, keyboard->get_repeat_fd(),
+                  &repeat_ev) < 0) {
+      LOG_ERROR("epoll_ctl: {}", std::strerror(errno));
+    }
+    keyboard_handler = keyboard.get();
+    DLOG_TRACE("Added Keyboard: {}", name);
+  }
+  if (caps & SeatObserver::SEAT_CAPABILITIES_TABLET_PAD) {
+    DLOG_TRACE("Added Tablet Pad: {}", name);
+  }
+  if (caps & SeatObserver::SEAT_CAPABILITIES_TABLET_TOOL) {
+    if (!tablet_) {
+      tablet_ = std::make_shared<Tablet>(event_mask_.tablet);
+      tablet_->set_motion_coalescing(coalesce_.enabled, coalesce_.keep_history);
+      tablet_->set_output_size(output_.width, output_.height);
+    }
+    DLOG_TRACE("Added Tablet Tool: {}", name);
+  }
+  if (record.device != 0) {
+    device_states_[record.device] = {.caps = caps,
+                                     .keyboard = keyboard_handler};
+  }
+  capabilities_ |= caps;
+  if (!capabilities_init_) {
+    notify_capabilities();
+  }
+}
+
+void Seat::handle_device_removed(const EventRecord& record,
+                                 libinput_device* dev) {
+  const auto name = dev ? libinput_device_get_name(dev) : "replay";
+  if (record.caps & SeatObserver::SEAT_CAPABILITIES_TOUCH) {
+    DLOG_TRACE("{}: Touch Removed", name);
+  }
+  if (record.caps & SeatObserver::SEAT_CAPABILITIES_SWITCH) {
+    DLOG_TRACE("{}: Switch Removed", name);
+  }
+  if (record.caps & SeatObserver::SEAT_CAPABILITIES_GESTURE) {
+    DLOG_TRACE("{}: Gesture Removed", name);
+  }
+  if (record.caps & SeatObserver::SEAT_CAPABILITIES_POINTER) {
+    DLOG_TRACE("{}: Pointer Removed", name);
+  }
+  if (record.caps & SeatObserver::SEAT_CAPABILITIES_KEYBOARD) {
+    DLOG_TRACE("{}: Keyboard Removed", name);
+  }
+  if (record.caps & SeatObserver::SEAT_CAPABILITIES_TABLET_PAD) {
+    DLOG_TRACE("{}: Tablet Pad Removed", name);
+  }
+  if (record.caps & SeatObserver::SEAT_CAPABILITIES_TABLET_TOOL) {
+    DLOG_TRACE("{}: Tablet Tool Removed", name);
+  }
+
+  const auto it = device_states_.find(record.device);
+  if (it == device_states_.end()) {
+    return;
+  }
+  if (const auto keyboard = it->second.keyboard) {
+    // stop servicing the repeat timer before the keyboard is freed
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, keyboard->get_repeat_fd(), nullptr);
+    keyboards_->erase(
+        std::remove_if(keyboards_->begin(), keyboards_->end(),
+                       [keyboard](const std::unique_ptr<Keyboard>& k) {
+                         return k.get() == keyboard;
+                       }),
+        keyboards_->end());
+  }
+  device_states_.erase(it);
+
+  uint32_t caps = 0;
+  for (const auto& [id, state] : device_states_) {
+    caps |= state.caps;
+  }
+  if (caps != capabilities_) {
+    capabilities_ = caps;
+    if (!capabilities_init_) {
+      notify_capabilities();
+    }
+  }
+}
+
+void Seat::notify_capabilities() {
+  observers_.for_each([this](SeatObserver* observer) {
+    observer->notify_seat_capabilities(this, capabilities_);
+  });
+}
+
+Seat::xkb_names Seat::get_xkb_names(libinput_device* dev) {
+  xkb_names names{};
+  const auto udev_device = libinput_device_get_udev_device(dev);
+  if (!udev_device) {
+    return names;
+  }
+  const auto property = [udev_device](const char* key) {
+    const auto value = udev_device_get_property_value(udev_device, key);
+    return std::string(value ? value : "");
+  };
+  names.model = property("XKBMODEL");
+  names.layout = property("XKBLAYOUT");
+  names.variant = property("XKBVARIANT");
+  names.options = property("XKBOPTIONS");
+  udev_device_unref(udev_device);
+  return names;
+}
+
+bool Seat::start_input_thread() {
+  if (input_thread_.joinable()) {
+    return true;
+  }
+  input_wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  input_ready_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (input_wake_fd_ < 0 || input_ready_fd_ < 0) {
+    LOG_ERROR("eventfd: {}", std::strerror(errno));
+    stop_input_thread();
+    return false;
+  }
+  input_ring_ =
+      std::make_unique<utils::SpscRing<EventRecord, kInputRingSize>>();
+
+  // the seat epoll set now waits for records instead of libinput
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.ptr = this;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, libinput_get_fd(li_), nullptr);
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, input_ready_fd_, &ev) < 0) {
+    LOG_ERROR("epoll_ctl: {}", std::strerror(errno));
+  }
+
+  input_running_ = true;
+  input_thread_ = std::thread(&Seat::input_thread_main, this);
+  return true;
+}
+
+void Seat::join_input_thread() {
+  if (!input_thread_.joinable()) {
+    return;
+  }
+  input_running_ = false;
+  constexpr uint64_t one = 1;
+  if (write(input_wake_fd_, &one, sizeof(one)) < 0) {
+    LOG_ERROR("eventfd write: {}", std::strerror(errno));
+  }
+  input_thread_.join();
+}
+
+void Seat::stop_input_thread() {
+  if (input_thread_.joinable()) {
+    join_input_thread();
+    // deliver what the thread queued before it stopped
+    drain_input();
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.ptr = this;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, input_ready_fd_, nullptr);
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, libinput_get_fd(li_), &ev) < 0) {
+      LOG_ERROR("epoll_ctl: {}", std::strerror(errno));
+    }
+  }
+  input_ring_.reset();
+  if (input_wake_fd_ >= 0) {
+    close(input_wake_fd_);
+    input_wake_fd_ = -1;
+  }
+  if (input_ready_fd_ >= 0) {
+    close(input_ready_fd_);
+    input_ready_fd_ = -1;
+  }
+}
+
+void Seat::input_thread_main() {
+  pollfd fds[2] = {
+      {.fd = libinput_get_fd(li_), .events = POLLIN, .revents = 0},
+      {.fd = input_wake_fd_, .events = POLLIN, .revents = 0},
+  };
+  EventRecord record{};
+  bool pending = false;
+
+  while (input_running_) {
+    if (send_events_dirty_.exchange(false)) {
+      for (auto& [dev, info] : devices_) {
+        apply_send_events(dev, info.disabled);
+      }
+    }
+    libinput_dispatch(li_);
+    size_t pushed = 0;
+    for (;;) {
+      if (!pending) {
+        const auto ev = libinput_get_event(li_);
+        if (!ev) {
+          break;
         }
-        if (libinput_device_has_capability(device,
-                                           LIBINPUT_DEVICE_CAP_KEYBOARD)) {
-          DLOG_TRACE("{}: Keyboard Removed", name);
+        if (filter_event(ev)) {
+          libinput_event_destroy(ev);
+          continue;
         }
-        if (libinput_device_has_capability(device,
-                                           LIBINPUT_DEVICE_CAP_TABLET_PAD)) {
-          DLOG_TRACE("{}: Tablet Pad Removed", name);
+        record = decode_event(ev);
+        if (record.type == LIBINPUT_EVENT_DEVICE_ADDED &&
+            record.caps & SeatObserver::SEAT_CAPABILITIES_KEYBOARD) {
+          // compile the keymap here so the consumer only hits the cache
+          auto names = get_xkb_names(libinput_event_get_device(ev));
+          keymap_cache_->get_keymap(
+              nullptr, names.model.c_str(), names.layout.c_str(),
+              names.variant.c_str(), names.options.c_str());
+          std::scoped_lock lock(pending_names_mutex_);
+          pending_names_[record.device] = std::move(names);
+        } else if (record.type == LIBINPUT_EVENT_DEVICE_REMOVED) {
+          release_device(libinput_event_get_device(ev));
         }
-        if (libinput_device_has_capability(device,
-                                           LIBINPUT_DEVICE_CAP_TABLET_TOOL)) {
-          DLOG_TRACE("{}: Tablet Tool Removed", name);
+        libinput_event_destroy(ev);
+        if (recorder_) {
+          recorder_->append(record);
         }
-        break;
+        pending = true;
       }
-      case LIBINPUT_EVENT_KEYBOARD_KEY: {
-        const auto key_event = libinput_event_get_keyboard_event(ev);
-        for (const auto& keyboard : *keyboards_) {
-          keyboard->handle_keyboard_event(key_event);
-        }
+      if (!input_ring_->push(record)) {
+        // the consumer is behind, leave the rest in the libinput queue
+        input_ring_stalls_++;
         break;
       }
-      case LIBINPUT_EVENT_POINTER_BUTTON:
-        pointer_->handle_pointer_button_event(
-            libinput_event_get_pointer_event(ev));
-        break;
-      case LIBINPUT_EVENT_POINTER_MOTION:
-        pointer_->handle_pointer_motion_event(
-            libinput_event_get_pointer_event(ev));
-        break;
-      case LIBINPUT_EVENT_POINTER_AXIS:
-        pointer_->handle_pointer_axis_event(
-            libinput_event_get_pointer_event(ev));
-        break;
-      case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE: {
-        pointer_->handle_pointer_motion_absolute_event(
-            libinput_event_get_pointer_event(ev));
-        break;
+      pending = false;
+      pushed++;
+    }
+
+    if (pushed) {
+      constexpr uint64_t one = 1;
+      if (write(input_ready_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        LOG_ERROR("eventfd write: {}", std::strerror(errno));
       }
-      case LIBINPUT_EVENT_TOUCH_UP:
-        touch_->handle_touch_up(libinput_event_get_touch_event(ev));
-        break;
-      case LIBINPUT_EVENT_TOUCH_DOWN:
-        touch_->handle_touch_down(libinput_event_get_touch_event(ev));
-        break;
-      case LIBINPUT_EVENT_TOUCH_FRAME:
-        touch_->handle_touch_frame(libinput_event_get_touch_event(ev));
-        break;
-      case LIBINPUT_EVENT_TOUCH_CANCEL:
-        touch_->handle_touch_cancel(libinput_event_get_touch_event(ev));
-        break;
-      case LIBINPUT_EVENT_TOUCH_MOTION:
-        touch_->handle_touch_motion(libinput_event_get_touch_event(ev));
-        break;
-      default: {
-        LOG_INFO("Event Type: {}", static_cast<int>(type));
-        break;
+    }
+
+    // poll briefly while the ring is full so the backlog is retried
+    if (poll(fds, 2, pending ? 1 : -1) < 0 && errno != EINTR) {
+      LOG_ERROR("poll: {}", std::strerror(errno));
+      break;
+    }
+    if (fds[1].revents & POLLIN) {
+      // reset the wakeup, send_events_dirty_ is checked at the loop top
+      uint64_t value;
+      if (read(input_wake_fd_, &value, sizeof(value)) < 0 &&
+          errno != EAGAIN) {
+        LOG_ERROR("eventfd read: {}", std::strerror(errno));
       }
     }
-    libinput_event_destroy(ev);
+  }
+}
+
+size_t Seat::drain_input(const size_t max_events,
+                         const std::chrono::microseconds budget) {
+  if (!input_ring_) {
+    return 0;
+  }
+  // services only the key repeat timers that fired, on this thread
+  poll_fds(0);
+  return drain_ring(max_events, budget);
+}
+
+size_t Seat::drain_ring(const size_t max_events,
+                        const std::chrono::microseconds budget) {
+  uint64_t value;
+  if (read(input_ready_fd_, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+    LOG_ERROR("eventfd read: {}", std::strerror(errno));
   }
 
+  const auto start = std::chrono::steady_clock::now();
+  size_t count = 0;
+  EventRecord record{};
+  while ((max_events == 0 || count < max_events) && input_ring_->pop(record)) {
+    dispatch_record(record, nullptr);
+    count++;
+
+    // checked per record as in dispatch_all, the rest stays in the ring
+    if (budget.count() > 0 &&
+        std::chrono::steady_clock::now() - start >= budget) {
+      break;
+    }
+  }
+  if (input_ring_->size() != 0) {
+    // the ready eventfd was consumed above, keep the seat fd readable
+    constexpr uint64_t one = 1;
+    if (write(input_ready_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+      LOG_ERROR("eventfd write: {}", std::strerror(errno));
+    }
+  }
+
+  last_dispatch_count_ = count;
+  events_handled_ += count;
+  return count;
+}
+
+bool Seat::start_recording(const std::string& path) {
+  auto recorder = std::make_unique<EventRecorder>();
+  if (!recorder->open(path)) {
+    return false;
+  }
+  recorder_ = std::move(recorder);
   return true;
 }
 
+void Seat::stop_recording() {
+  recorder_.reset();
+}
+
 std::optional<std::shared_ptr<std::vector<std::unique_ptr<Keyboard>>>>
 Seat::get_keyboards() const {
   if (keyboards_) {
@@ -279,6 +1286,73 @@ std::optional<std::shared_ptr<Pointer>> Seat::get_pointer() const {
   return pointer_;
 }
 
+std::optional<std::shared_ptr<Touch>> Seat::get_touch() const {
+  if (!touch_) {
+    return {};
+  }
+  return touch_;
+}
+
+std::optional<std::shared_ptr<Tablet>> Seat::get_tablet() const {
+  if (!tablet_) {
+    return {};
+  }
+  return tablet_;
+}
+
+std::optional<std::shared_ptr<Gesture>> Seat::get_gesture() const {
+  if (!gesture_) {
+    return {};
+  }
+  return gesture_;
+}
+
+void Seat::set_motion_coalescing(const bool enable, const bool keep_history) {
+  coalesce_.enabled = enable;
+  coalesce_.keep_history = keep_history;
+  if (pointer_) {
+    pointer_->set_motion_coalescing(enable, keep_history);
+  }
+  if (touch_) {
+    touch_->set_motion_coalescing(enable, keep_history);
+  }
+  if (tablet_) {
+    tablet_->set_motion_coalescing(enable, keep_history);
+  }
+  if (gesture_) {
+    gesture_->set_motion_coalescing(enable);
+  }
+}
+
+void Seat::set_output_size(const uint32_t width, const uint32_t height) {
+  output_.width = width;
+  output_.height = height;
+  if (pointer_) {
+    pointer_->set_output_size(width, height);
+  }
+  if (touch_) {
+    touch_->set_output_size(width, height);
+  }
+  if (tablet_) {
+    tablet_->set_output_size(width, height);
+  }
+}
+
+void Seat::flush_motion() const {
+  if (pointer_) {
+    pointer_->flush_motion();
+  }
+  if (touch_) {
+    touch_->flush_motion();
+  }
+  if (tablet_) {
+    tablet_->flush_motion();
+  }
+  if (gesture_) {
+    gesture_->flush_motion();
+  }
+}
+
 void Seat::event_mask_print() const {
   const std::string out;
   std::stringstream ss(out);
@@ -303,6 +1377,10 @@ void Seat::event_mask_print() const {
   if (event_mask_.touch.all)
     ss << "\n\ttouch";
 #endif  // TODO
+  if (event_mask_.tablet.all)
+    ss << "\n\ttablet";
+  if (event_mask_.gesture.all)
+    ss << "\n\tgesture";
   LOG_INFO(ss.str());
 }
 
@@ -346,8 +1424,10 @@ void Seat::set_event_mask(const char* ignore_events) {
       if (event == "keyboard") {
         event_mask_.keyboard.all = true;
       }
-      for (const auto& keyboard : *keyboards_) {
-        keyboard->set_event_mask(event_mask_.keyboard);
+      if (keyboards_) {
+        for (const auto& keyboard : *keyboards_) {
+          keyboard->set_event_mask(event_mask_.keyboard);
+        }
       }
     } else if (event.rfind("touch", 0) == 0) {
       event_mask_.touch.all = true;
@@ -357,10 +1437,21 @@ void Seat::set_event_mask(const char* ignore_events) {
       if (touch_) {
         touch_->set_event_mask(event_mask_.touch);
       }
+    } else if (event == "tablet") {
+      event_mask_.tablet = {.enabled = true, .all = true};
+      if (tablet_) {
+        tablet_->set_event_mask(event_mask_.tablet);
+      }
+    } else if (event == "gesture") {
+      event_mask_.gesture = {.enabled = true, .all = true};
+      if (gesture_) {
+        gesture_->set_event_mask(event_mask_.gesture);
+      }
     } else {
       LOG_WARN("Unknown Event Mask: [{}]", event);
     }
   }
+  update_masked_events();
   if (!mask_events.empty()) {
     event_mask_print();
   }
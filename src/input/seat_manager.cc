@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "input/seat_manager.h"
+
+#include <cstring>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "input/keymap_cache.h"
+#include "input/seat.h"
+#include "kms/output.h"
+#include "logging/logging.h"
+
+namespace drmpp::input {
+namespace {
+/// seat of devices without an ID_SEAT property, as in libinput
+constexpr char kDefaultSeat[] = "seat0";
+}  // namespace
+
+SeatManager::SeatManager(const bool disable_cursor, const char* ignore_events)
+    : udev_(udev_new()),
+      disable_cursor_(disable_cursor),
+      ignore_events_(ignore_events ? ignore_events : ""),
+      keymap_cache_(std::make_shared<KeymapCache>()) {
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0) {
+    LOG_ERROR("epoll_create1: {}", std::strerror(errno));
+    return;
+  }
+
+  udev_monitor_ = udev_monitor_new_from_netlink(udev_, "udev");
+  if (!udev_monitor_) {
+    LOG_ERROR("Failed to create udev monitor");
+    return;
+  }
+  udev_monitor_filter_add_match_subsystem_devtype(udev_monitor_, "input",
+                                                  nullptr);
+  udev_monitor_enable_receiving(udev_monitor_);
+
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.ptr = this;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, udev_monitor_get_fd(udev_monitor_),
+                &ev) < 0) {
+    LOG_ERROR("epoll_ctl: {}", std::strerror(errno));
+  }
+}
+
+SeatManager::~SeatManager() {
+  seats_.clear();
+  if (udev_monitor_) {
+    udev_monitor_unref(udev_monitor_);
+  }
+  if (epoll_fd_ >= 0) {
+    close(epoll_fd_);
+  }
+  if (udev_) {
+    udev_unref(udev_);
+  }
+}
+
+void SeatManager::register_observer(SeatManagerObserver* observer) {
+  observers_.add(observer);
+}
+
+void SeatManager::unregister_observer(SeatManagerObserver* observer) {
+  observers_.remove(observer);
+}
+
+void SeatManager::scan_devices() {
+  const auto enumerate = udev_enumerate_new(udev_);
+  udev_enumerate_add_match_subsystem(enumerate, "input");
+  udev_enumerate_scan_devices(enumerate);
+
+  udev_list_entry* entry;
+  udev_list_entry_foreach(entry, udev_enumerate_get_list_entry(enumerate)) {
+    const auto device =
+        udev_device_new_from_syspath(udev_, udev_list_entry_get_name(entry));
+    if (device) {
+      add_device(device);
+      udev_device_unref(device);
+    }
+  }
+  udev_enumerate_unref(enumerate);
+}
+
+int SeatManager::wait_and_dispatch(const int timeout_ms) {
+  epoll_event events[16];
+  const int res = epoll_wait(epoll_fd_, events, 16, timeout_ms);
+  if (res < 0) {
+    if (errno == EINTR) {
+      return 0;
+    }
+    LOG_ERROR("epoll_wait: {}", std::strerror(errno));
+    return -1;
+  }
+
+  int count = 0;
+  for (int i = 0; i < res; i++) {
+    if (events[i].data.ptr == this) {
+      handle_udev_event();
+    } else if (const int handled =
+                   static_cast<Seat*>(events[i].data.ptr)->wait_and_dispatch(0);
+               handled > 0) {
+      count += handled;
+    }
+  }
+  return count;
+}
+
+Seat* SeatManager::get_seat(const std::string& seat_id) const {
+  const auto it = seats_.find(seat_id);
+  return it != seats_.end() ? it->second.get() : nullptr;
+}
+
+void SeatManager::set_seat_outputs(const std::string& seat_id,
+                                   std::vector<const Output*> outputs) {
+  seat_outputs_[seat_id] = std::move(outputs);
+  if (const auto seat = get_seat(seat_id)) {
+    apply_outputs(*seat);
+  }
+}
+
+std::vector<const Output*> SeatManager::get_seat_outputs(
+    const std::string& seat_id) const {
+  const auto it = seat_outputs_.find(seat_id);
+  if (it == seat_outputs_.end()) {
+    return {};
+  }
+  return it->second;
+}
+
+void SeatManager::add_device(udev_device* device) {
+  const auto dev_node = udev_device_get_devnode(device);
+  const auto sys_name = udev_device_get_sysname(device);
+  if (!dev_node || !sys_name || std::strncmp(sys_name, "event", 5) != 0) {
+    return;
+  }
+  // the same filter libinput applies to udev devices
+  if (!udev_device_get_property_value(device, "ID_INPUT")) {
+    return;
+  }
+  if (device_seats_.count(dev_node)) {
+    return;
+  }
+
+  const auto id_seat = udev_device_get_property_value(device, "ID_SEAT");
+  const std::string seat_id = id_seat ? id_seat : kDefaultSeat;
+  auto& seat = ensure_seat(seat_id);
+  if (!seat.add_path_device(dev_node)) {
+    return;
+  }
+  device_seats_[dev_node] = seat_id;
+  DLOG_DEBUG("{}: {}", seat_id, dev_node);
+
+  // device added events are queued without the fd becoming readable
+  seat.dispatch_all();
+}
+
+void SeatManager::remove_device(const char* dev_node) {
+  const auto it = device_seats_.find(dev_node);
+  if (it == device_seats_.end()) {
+    return;
+  }
+  if (const auto seat = get_seat(it->second)) {
+    seat->remove_path_device(dev_node);
+    seat->dispatch_all();
+  }
+  device_seats_.erase(it);
+}
+
+void SeatManager::handle_udev_event() {
+  const auto device = udev_monitor_receive_device(udev_monitor_);
+  if (!device) {
+    return;
+  }
+  const auto action = udev_device_get_action(device);
+  if (action && std::strcmp(action, "add") == 0) {
+    add_device(device);
+  } else if (action && std::strcmp(action, "remove") == 0) {
+    if (const auto dev_node = udev_device_get_devnode(device)) {
+      remove_device(dev_node);
+    }
+  }
+  udev_device_unref(device);
+}
+
+Seat& SeatManager::ensure_seat(const std::string& seat_id) {
+  if (const auto it = seats_.find(seat_id); it != seats_.end()) {
+    return *it->second;
+  }
+
+  auto seat = std::make_unique<Seat>(
+      keymap_cache_, seat_id.c_str(), disable_cursor_,
+      ignore_events_.empty() ? nullptr : ignore_events_.c_str());
+  seat->attach_to_epoll(epoll_fd_);
+  apply_outputs(*seat);
+
+  auto& result = *seats_.emplace(seat_id, std::move(seat)).first->second;
+  LOG_INFO("Seat added: {}", seat_id);
+  observers_.for_each([&](SeatManagerObserver* observer) {
+    observer->notify_seat_added(this, &result);
+  });
+  return result;
+}
+
+void SeatManager::apply_outputs(Seat& seat) const {
+  const auto it = seat_outputs_.find(seat.get_name());
+  if (it == seat_outputs_.end() || it->second.empty() || !it->second[0]) {
+    return;
+  }
+  const auto output = it->second[0];
+  seat.set_output_size(output->GetWidth(), output->GetHeight());
+}
+}  // namespace drmpp::input
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "input/tablet.h"
+
+namespace drmpp::input {
+Tablet::Tablet(event_mask const& event_mask) {
+  event_mask_ = {
+      .enabled = event_mask.enabled,
+      .all = event_mask.all,
+  };
+}
+
+void Tablet::set_event_mask(event_mask const& event_mask) {
+  event_mask_.enabled = event_mask.enabled;
+  event_mask_.all = event_mask.all;
+  if (is_masked()) {
+    axis_pending_ = false;
+    axis_history_.clear();
+  }
+}
+
+void Tablet::set_output_size(const uint32_t width, const uint32_t height) {
+  output_.width = width;
+  output_.height = height;
+}
+
+void Tablet::set_motion_coalescing(const bool enable, const bool keep_history) {
+  if (!enable) {
+    flush_motion();
+  }
+  coalesce_ = enable;
+  keep_history_ = enable && keep_history;
+  axis_history_.clear();
+}
+
+void Tablet::flush_motion() {
+  if (axis_pending_) {
+    axis_pending_ = false;
+    observers_.for_each([&](TabletObserver* observer) {
+      observer->notify_tablet_tool_axis(this, axis_time_, state_);
+    });
+  }
+  axis_history_.clear();
+}
+
+void Tablet::set_position(const double x,
+                          const double y,
+                          const double nx,
+                          const double ny) {
+  if (output_.width && output_.height) {
+    state_.x = nx * output_.width;
+    state_.y = ny * output_.height;
+  } else {
+    state_.x = x;
+    state_.y = y;
+  }
+}
+
+void Tablet::handle_tool_proximity(const uint32_t time,
+                                   const uint32_t tool_type,
+                                   const bool in_proximity,
+                                   const double x,
+                                   const double y,
+                                   const double nx,
+                                   const double ny,
+                                   const uint64_t time_usec) {
+  if (is_masked()) {
+    return;
+  }
+  if (coalesce_) {
+    flush_motion();
+  }
+  state_.time_usec = time_usec;
+  state_.tool_type = tool_type;
+  state_.in_proximity = in_proximity;
+  if (!in_proximity) {
+    state_.tip_down = false;
+    state_.pressure = 0;
+  }
+  set_position(x, y, nx, ny);
+  observers_.for_each([&](TabletObserver* observer) {
+    observer->notify_tablet_tool_proximity(this, time, state_);
+  });
+}
+
+void Tablet::handle_tool_tip(const uint32_t time,
+                             const bool tip_down,
+                             const double x,
+                             const double y,
+                             const double nx,
+                             const double ny,
+                             const double pressure,
+                             const uint64_t time_usec) {
+  if (is_masked()) {
+    return;
+  }
+  if (coalesce_) {
+    flush_motion();
+  }
+  state_.time_usec = time_usec;
+  state_.tip_down = tip_down;
+  state_.pressure = pressure;
+  set_position(x, y, nx, ny);
+  observers_.for_each([&](TabletObserver* observer) {
+    observer->notify_tablet_tool_tip(this, time, state_);
+  });
+}
+
+void Tablet::handle_tool_axis(const uint32_t time,
+                              const double x,
+                              const double y,
+                              const double nx,
+                              const double ny,
+                              const double pressure,
+                              const double tilt_x,
+                              const double tilt_y,
+                              const uint64_t time_usec) {
+  if (is_masked()) {
+    return;
+  }
+  state_.time_usec = time_usec;
+  state_.pressure = pressure;
+  state_.tilt_x = tilt_x;
+  state_.tilt_y = tilt_y;
+  set_position(x, y, nx, ny);
+
+  if (coalesce_) {
+    axis_pending_ = true;
+    axis_time_ = time;
+    if (keep_history_) {
+      axis_history_.push_back(state_);
+    }
+    return;
+  }
+
+  observers_.for_each([&](TabletObserver* observer) {
+    observer->notify_tablet_tool_axis(this, time, state_);
+  });
+}
+
+void Tablet::handle_tool_button(const uint32_t time,
+                                const uint32_t button,
+                                const uint32_t state) {
+  if (is_masked()) {
+    return;
+  }
+  if (coalesce_) {
+    flush_motion();
+  }
+  observers_.for_each([&](TabletObserver* observer) {
+    observer->notify_tablet_tool_button(this, time, button, state);
+  });
+}
+}  // namespace drmpp::input
@@ -16,6 +16,9 @@
 
 #include "input/touch.h"
 
+#include <algorithm>
+#include <tuple>
+
 namespace drmpp::input {
 Touch::Touch(event_mask const& event_mask) {
   event_mask_ = {
@@ -29,47 +32,287 @@ Touch::~Touch() = default;
 void Touch::set_event_mask(event_mask const& event_mask) {
   event_mask_.enabled = event_mask.enabled;
   event_mask_.all = event_mask.all;
+  if (event_mask_.enabled && event_mask_.all) {
+    // contacts would never see their up event
+    contacts_.clear();
+    predictors_.clear();
+    pending_motion_.clear();
+  }
 }
 
-void Touch::handle_touch_up(libinput_event_touch* ev) {
-  std::scoped_lock lock(observers_mutex_);
-  for (const auto observer : observers_) {
-    observer->notify_touch_up(this, libinput_event_touch_get_time(ev),
-                              libinput_event_touch_get_x(ev),
-                              libinput_event_touch_get_y(ev));
+void Touch::set_motion_coalescing(const bool enable, const bool keep_history) {
+  if (!enable) {
+    flush_motion();
   }
+  coalesce_ = enable;
+  keep_history_ = enable && keep_history;
+  motion_history_.clear();
 }
 
-void Touch::handle_touch_down(libinput_event_touch* ev) {
-  std::scoped_lock lock(observers_mutex_);
-  for (const auto observer : observers_) {
-    observer->notify_touch_down(this, libinput_event_touch_get_time(ev),
-                                libinput_event_touch_get_x(ev),
-                                libinput_event_touch_get_y(ev));
+void Touch::flush_motion() {
+  for (const auto& motion : pending_motion_) {
+    observers_.for_each([&](TouchObserver* observer) {
+      observer->notify_touch_motion(this, motion.time, motion.x, motion.y);
+    });
   }
+  pending_motion_.clear();
+  motion_history_.clear();
 }
 
-void Touch::handle_touch_frame(libinput_event_touch* ev) {
-  std::scoped_lock lock(observers_mutex_);
-  for (const auto observer : observers_) {
-    observer->notify_touch_frame(this, libinput_event_touch_get_time(ev));
+void Touch::set_output_size(const uint32_t width, const uint32_t height) {
+  output_.width = width;
+  output_.height = height;
+  predictors_.clear();
+}
+
+void Touch::set_prediction(const bool enable,
+                           const MotionPredictor::params& params) {
+  predict_ = enable;
+  predictor_params_ = params;
+  predictors_.clear();
+}
+
+MotionPredictor::prediction Touch::predict(const int32_t seat_slot,
+                                           const uint64_t target_usec) const {
+  const auto contact = std::find_if(
+      contacts_.begin(), contacts_.end(),
+      [seat_slot](const TouchContact& c) { return c.seat_slot == seat_slot; });
+  if (contact == contacts_.end()) {
+    return {0, 0, 0};
   }
+  const auto it = std::find_if(
+      predictors_.begin(), predictors_.end(),
+      [seat_slot](const auto& p) { return p.first == seat_slot; });
+  if (it != predictors_.end()) {
+    if (const auto prediction = it->second.predict(target_usec);
+        prediction.confidence > 0) {
+      return prediction;
+    }
+  }
+  return {contact->x, contact->y, 0};
 }
 
-void Touch::handle_touch_cancel(libinput_event_touch* ev) {
-  std::scoped_lock lock(observers_mutex_);
-  for (const auto observer : observers_) {
-    observer->notify_touch_cancel(this, libinput_event_touch_get_time(ev));
+std::pair<double, double> Touch::map_position(const double x,
+                                              const double y,
+                                              const double nx,
+                                              const double ny) const {
+  if (output_.width && output_.height) {
+    return {nx * output_.width, ny * output_.height};
+  }
+  return {x, y};
+}
+
+void Touch::update_contact(const int32_t slot,
+                           const int32_t seat_slot,
+                           const TouchContact::State state,
+                           const double x,
+                           const double y,
+                           const double nx,
+                           const double ny,
+                           const uint64_t time_usec) {
+  auto it = std::find_if(contacts_.begin(), contacts_.end(),
+                         [seat_slot](const TouchContact& contact) {
+                           return contact.seat_slot == seat_slot;
+                         });
+  if (it == contacts_.end()) {
+    if (state != TouchContact::TOUCH_CONTACT_DOWN) {
+      return;
+    }
+    it = contacts_.insert(contacts_.end(), {slot, seat_slot, state, 0, 0});
+  } else if (state != TouchContact::TOUCH_CONTACT_MOTION ||
+             it->state != TouchContact::TOUCH_CONTACT_DOWN) {
+    // a contact that went down and moved in the same frame stays down
+    it->state = state;
   }
+  if (state == TouchContact::TOUCH_CONTACT_UP) {
+    return;
+  }
+  std::tie(it->x, it->y) = map_position(x, y, nx, ny);
+
+  if (predict_) {
+    auto predictor = std::find_if(
+        predictors_.begin(), predictors_.end(),
+        [seat_slot](const auto& p) { return p.first == seat_slot; });
+    if (predictor == predictors_.end()) {
+      predictor = predictors_.insert(
+          predictors_.end(), {seat_slot, MotionPredictor(predictor_params_)});
+    } else if (state == TouchContact::TOUCH_CONTACT_DOWN) {
+      predictor->second.reset();
+    }
+    predictor->second.update(time_usec, it->x, it->y);
+  }
+}
+
+void Touch::handle_touch_up(libinput_event_touch* ev) {
+  handle_touch_up(libinput_event_touch_get_time(ev),
+                  libinput_event_touch_get_slot(ev),
+                  libinput_event_touch_get_seat_slot(ev));
+}
+
+void Touch::handle_touch_down(libinput_event_touch* ev) {
+  handle_touch_down(libinput_event_touch_get_time(ev),
+                    libinput_event_touch_get_slot(ev),
+                    libinput_event_touch_get_seat_slot(ev),
+                    libinput_event_touch_get_x(ev),
+                    libinput_event_touch_get_y(ev),
+                    libinput_event_touch_get_x_transformed(ev, 1),
+                    libinput_event_touch_get_y_transformed(ev, 1),
+                    libinput_event_touch_get_time_usec(ev));
+}
+
+void Touch::handle_touch_frame(libinput_event_touch* ev) {
+  handle_touch_frame(libinput_event_touch_get_time(ev));
+}
+
+void Touch::handle_touch_cancel(libinput_event_touch* ev) {
+  handle_touch_cancel(libinput_event_touch_get_time(ev));
 }
 
 void Touch::handle_touch_motion(libinput_event_touch* ev) {
-  std::scoped_lock lock(observers_mutex_);
-  for (const auto observer : observers_) {
-    observer->notify_touch_motion(this, libinput_event_touch_get_time(ev),
-                                  libinput_event_touch_get_x(ev),
-                                  libinput_event_touch_get_y(ev));
+  handle_touch_motion(libinput_event_touch_get_time(ev),
+                      libinput_event_touch_get_slot(ev),
+                      libinput_event_touch_get_seat_slot(ev),
+                      libinput_event_touch_get_x(ev),
+                      libinput_event_touch_get_y(ev),
+                      libinput_event_touch_get_x_transformed(ev, 1),
+                      libinput_event_touch_get_y_transformed(ev, 1),
+                      libinput_event_touch_get_time_usec(ev));
+}
+
+void Touch::handle_touch_up(const uint32_t time,
+                            const int32_t slot,
+                            const int32_t seat_slot) {
+  if (event_mask_.enabled && event_mask_.all) {
+    return;
+  }
+  update_contact(slot, seat_slot, TouchContact::TOUCH_CONTACT_UP, 0, 0, 0, 0,
+                 0);
+  if (batch_frames_) {
+    return;
+  }
+  if (coalesce_) {
+    flush_motion();
+  }
+  // libinput provides no coordinates for touch up
+  observers_.for_each([&](TouchObserver* observer) {
+    observer->notify_touch_up(this, time, 0, 0);
+  });
+}
+
+void Touch::handle_touch_down(const uint32_t time,
+                              const int32_t slot,
+                              const int32_t seat_slot,
+                              const double x,
+                              const double y,
+                              const double nx,
+                              const double ny,
+                              const uint64_t time_usec) {
+  if (event_mask_.enabled && event_mask_.all) {
+    return;
+  }
+  update_contact(slot, seat_slot, TouchContact::TOUCH_CONTACT_DOWN, x, y, nx,
+                 ny, time_usec ? time_usec : time * 1000ULL);
+  if (batch_frames_) {
+    return;
+  }
+  if (coalesce_) {
+    flush_motion();
   }
+  const auto position = map_position(x, y, nx, ny);
+  observers_.for_each([&](TouchObserver* observer) {
+    observer->notify_touch_down(this, time, position.first, position.second);
+  });
 }
 
-}  // namespace drmpp::input
\ No newline at end of file
+void Touch::handle_touch_frame(const uint32_t time) {
+  if (event_mask_.enabled && event_mask_.all) {
+    return;
+  }
+  if (batch_frames_) {
+    if (!contacts_.empty()) {
+      observers_.for_each([&](TouchObserver* observer) {
+        observer->notify_touch_frame_batch(this, time, contacts_);
+      });
+    }
+  } else {
+    observers_.for_each([&](TouchObserver* observer) {
+      observer->notify_touch_frame(this, time);
+    });
+  }
+
+  for (const auto& contact : contacts_) {
+    if (contact.state == TouchContact::TOUCH_CONTACT_UP) {
+      predictors_.erase(
+          std::remove_if(predictors_.begin(), predictors_.end(),
+                         [&contact](const auto& p) {
+                           return p.first == contact.seat_slot;
+                         }),
+          predictors_.end());
+    }
+  }
+  contacts_.erase(std::remove_if(contacts_.begin(), contacts_.end(),
+                                 [](const TouchContact& contact) {
+                                   return contact.state ==
+                                          TouchContact::TOUCH_CONTACT_UP;
+                                 }),
+                  contacts_.end());
+  for (auto& contact : contacts_) {
+    contact.state = TouchContact::TOUCH_CONTACT_STATIONARY;
+  }
+}
+
+void Touch::handle_touch_cancel(const uint32_t time) {
+  if (event_mask_.enabled && event_mask_.all) {
+    return;
+  }
+  contacts_.clear();
+  predictors_.clear();
+  if (coalesce_) {
+    flush_motion();
+  }
+  observers_.for_each([&](TouchObserver* observer) {
+    observer->notify_touch_cancel(this, time);
+  });
+}
+
+void Touch::handle_touch_motion(const uint32_t time,
+                                const int32_t slot,
+                                const int32_t seat_slot,
+                                const double x,
+                                const double y,
+                                const double nx,
+                                const double ny,
+                                const uint64_t time_usec) {
+  if (event_mask_.enabled && event_mask_.all) {
+    return;
+  }
+  update_contact(slot, seat_slot, TouchContact::TOUCH_CONTACT_MOTION, x, y, nx,
+                 ny, time_usec ? time_usec : time * 1000ULL);
+  if (batch_frames_) {
+    return;
+  }
+  const auto position = map_position(x, y, nx, ny);
+  if (coalesce_) {
+    // keyed by seat slot, device slots collide across touchscreens
+    const motion_sample sample{time, slot, seat_slot, position.first,
+                               position.second};
+    const auto it = std::find_if(pending_motion_.begin(), pending_motion_.end(),
+                                 [seat_slot](const motion_sample& pending) {
+                                   return pending.seat_slot == seat_slot;
+                                 });
+    if (it != pending_motion_.end()) {
+      *it = sample;
+    } else {
+      pending_motion_.push_back(sample);
+    }
+    if (keep_history_) {
+      motion_history_.push_back(sample);
+    }
+    return;
+  }
+
+  observers_.for_each([&](TouchObserver* observer) {
+    observer->notify_touch_motion(this, time, position.first, position.second);
+  });
+}
+}  // namespace drmpp::input
@@ -0,0 +1,176 @@
+
+#include "kms/cursor_animator.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "logging/logging.h"
+
+namespace {
+uint64_t now_usec() {
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+}  // namespace
+
+CursorAnimator::CursorAnimator(CursorPlane* plane, const Output* output)
+    : plane_(plane),
+      output_(output),
+      timer_fd_(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) {
+  if (timer_fd_ < 0) {
+    LOG_ERROR("Error timerfd_create: {}", strerror(errno));
+  }
+}
+
+CursorAnimator::~CursorAnimator() {
+  if (timer_fd_ >= 0) {
+    close(timer_fd_);
+  }
+}
+
+uint64_t CursorAnimator::GetDelayUsec(const size_t frame) const {
+  // a zero delay would spin, treat it as 1 ms like libXcursor users do
+  return std::max<uint64_t>(images_->images[frame]->delay, 1) * 1000;
+}
+
+bool CursorAnimator::SetCursor(
+    const std::shared_ptr<drmpp::XCursor::Images>& images) {
+  Disarm();
+  images_ = images;
+  frame_ = 0;
+  if (!images_ || images_->images.empty()) {
+    return false;
+  }
+
+  if (IsAnimated()) {
+    // upload every frame now so the animation never writes pixels
+    plane_->SetPoolCapacity(CursorPlane::kPoolCapacity +
+                            images_->images.size());
+    for (size_t i = images_->images.size(); i-- > 1;) {
+      if (!plane_->Upload(images_, i)) {
+        return false;
+      }
+    }
+  }
+  if (hidden_) {
+    return plane_->Upload(images_, 0);
+  }
+  if (!plane_->SetCursor(images_, 0)) {
+    return false;
+  }
+
+  if (IsAnimated()) {
+    const auto now = now_usec();
+    last_activity_usec_ = now;
+    due_usec_ = now + GetDelayUsec(0);
+    Arm(now);
+  }
+  return true;
+}
+
+bool CursorAnimator::Show() {
+  hidden_ = false;
+  if (!images_ || images_->images.empty()) {
+    return false;
+  }
+  if (!plane_->SetCursor(images_, frame_)) {
+    return false;
+  }
+  if (IsAnimated()) {
+    const auto now = now_usec();
+    last_activity_usec_ = now;
+    due_usec_ = now + GetDelayUsec(frame_);
+    Arm(now);
+  }
+  return true;
+}
+
+bool CursorAnimator::Hide() {
+  hidden_ = true;
+  Disarm();
+  return plane_->Hide();
+}
+
+void CursorAnimator::NotifyActivity() {
+  const auto now = now_usec();
+  last_activity_usec_ = now;
+  if (!armed_ && !hidden_ && IsAnimated() && plane_->IsVisible()) {
+    due_usec_ = now + GetDelayUsec(frame_);
+    Arm(now);
+  }
+}
+
+void CursorAnimator::HandleTimer() {
+  uint64_t expirations;
+  if (read(timer_fd_, &expirations, sizeof(expirations)) !=
+      sizeof(expirations)) {
+    return;
+  }
+  if (!armed_ || !IsAnimated()) {
+    return;
+  }
+  armed_ = false;
+
+  const auto now = now_usec();
+  if (hidden_ || !plane_->IsVisible() ||
+      now - last_activity_usec_ >= kIdleTimeoutUsec) {
+    DLOG_DEBUG("cursor animation paused");
+    return;
+  }
+
+  // frames due by the vblank this commit lands on, skipping missed ones
+  const auto deadline = now + kCommitLeadUsec;
+  const auto count = images_->images.size();
+  if (deadline > due_usec_) {
+    // whole cycles behind, e.g. after a suspend, are skipped keeping phase
+    uint64_t cycle = 0;
+    for (size_t i = 0; i < count; i++) {
+      cycle += GetDelayUsec(i);
+    }
+    due_usec_ += (deadline - due_usec_) / cycle * cycle;
+  }
+  while (due_usec_ <= deadline) {
+    frame_ = (frame_ + 1) % count;
+    due_usec_ += GetDelayUsec(frame_);
+  }
+
+  plane_->SetCursor(images_, frame_);
+  Arm(now);
+}
+
+void CursorAnimator::Arm(const uint64_t now) {
+  if (timer_fd_ < 0) {
+    return;
+  }
+  uint64_t target = due_usec_;
+  if (output_) {
+    const auto vblank = output_->EstimateNextVblank(due_usec_);
+    if (vblank >= now + kCommitLeadUsec) {
+      target = vblank - kCommitLeadUsec;
+    }
+  }
+  target = std::max(target, now + 1);
+
+  itimerspec its{};
+  its.it_value.tv_sec = static_cast<time_t>(target / 1000000);
+  its.it_value.tv_nsec = static_cast<long>(target % 1000000) * 1000;
+  if (timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &its, nullptr) < 0) {
+    LOG_ERROR("Error timerfd_settime: {}", strerror(errno));
+    return;
+  }
+  armed_ = true;
+}
+
+void CursorAnimator::Disarm() {
+  if (timer_fd_ >= 0 && armed_) {
+    constexpr itimerspec its{};
+    timerfd_settime(timer_fd_, 0, &its, nullptr);
+  }
+  armed_ = false;
+}
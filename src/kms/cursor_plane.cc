@@ -0,0 +1,435 @@
+
+#include "kms/cursor_plane.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+
+#include <drm_fourcc.h>
+#include <sys/mman.h>
+#include <xf86drm.h>
+
+#include "kms/output.h"
+#include "logging/logging.h"
+#include "shared_libs/libdrm.h"
+
+CursorPlane::CursorPlane(const int drm_fd,
+                         const uint32_t crtc_id,
+                         const uint32_t plane_id,
+                         const uint32_t width,
+                         const uint32_t height)
+    : drm_fd_(drm_fd),
+      crtc_id_(crtc_id),
+      plane_id_(plane_id),
+      width_(width),
+      height_(height) {
+  if (plane_id_) {
+    LookupProperties();
+  }
+}
+
+CursorPlane::~CursorPlane() {
+  if (visible_) {
+    // blocking, the buffers are destroyed below
+    visible_ = false;
+    Commit(true);
+  }
+  for (auto& buffer : pool_) {
+    DestroyBuffer(buffer);
+  }
+}
+
+std::unique_ptr<CursorPlane> CursorPlane::Create(const int drm_fd,
+                                                 const uint32_t crtc_id,
+                                                 const bool atomic) {
+  uint64_t cap;
+  const uint32_t width =
+      drm->GetCap(drm_fd, DRM_CAP_CURSOR_WIDTH, &cap) == 0 && cap ? cap : 64;
+  const uint32_t height =
+      drm->GetCap(drm_fd, DRM_CAP_CURSOR_HEIGHT, &cap) == 0 && cap ? cap : 64;
+
+  const auto resources = drm->ModeGetResources(drm_fd);
+  if (!resources) {
+    LOG_ERROR("Could not get card resources");
+    return nullptr;
+  }
+  int crtc_index = -1;
+  for (int c = 0; c < resources->count_crtcs; c++) {
+    if (resources->crtcs[c] == crtc_id) {
+      crtc_index = c;
+      break;
+    }
+  }
+  drm->ModeFreeResources(resources);
+  if (crtc_index < 0) {
+    LOG_ERROR("crtc_id {}: not found", crtc_id);
+    return nullptr;
+  }
+
+  // the kernel accepts the hotspot cap only once atomic is set, and only for
+  // drivers that need the hotspot. It exposes their cursor plane, so set it
+  // before looking the planes up.
+  if (atomic &&
+      drm->SetClientCap(drm_fd, DRM_CLIENT_CAP_CURSOR_PLANE_HOTSPOT, 1) == 0) {
+    LOG_DEBUG("cursor plane hotspot supported");
+  }
+
+  uint32_t plane_id = 0;
+  const auto plane_resources =
+      atomic ? drm->ModeGetPlaneResources(drm_fd) : nullptr;
+  for (uint32_t i = 0; plane_resources && i < plane_resources->count_planes &&
+                       plane_id == 0;
+       i++) {
+    const auto plane = drm->ModeGetPlane(drm_fd, plane_resources->planes[i]);
+    if (!plane) {
+      continue;
+    }
+    if ((plane->possible_crtcs & (1 << crtc_index)) &&
+        (plane->crtc_id == 0 || plane->crtc_id == crtc_id)) {
+      const auto props = drm->ModeObjectGetProperties(
+          drm_fd, plane->plane_id, DRM_MODE_OBJECT_PLANE);
+      for (uint32_t p = 0; props && p < props->count_props; p++) {
+        const auto prop = drm->ModeGetProperty(drm_fd, props->props[p]);
+        if (!prop) {
+          continue;
+        }
+        if (std::string_view(prop->name) == "type" &&
+            props->prop_values[p] == DRM_PLANE_TYPE_CURSOR) {
+          plane_id = plane->plane_id;
+        }
+        drm->ModeFreeProperty(prop);
+      }
+      if (props) {
+        drm->ModeFreeObjectProperties(props);
+      }
+    }
+    drm->ModeFreePlane(plane);
+  }
+  if (plane_resources) {
+    drm->ModeFreePlaneResources(plane_resources);
+  }
+
+  if (plane_id) {
+    LOG_DEBUG("crtc_id {}: cursor plane_id {}, {}x{}", crtc_id, plane_id,
+              width, height);
+  } else {
+    LOG_DEBUG("crtc_id {}: legacy cursor, {}x{}", crtc_id, width, height);
+  }
+  return std::make_unique<CursorPlane>(drm_fd, crtc_id, plane_id, width,
+                                       height);
+}
+
+void CursorPlane::LookupProperties() {
+  const auto props =
+      drm->ModeObjectGetProperties(drm_fd_, plane_id_, DRM_MODE_OBJECT_PLANE);
+  if (!props) {
+    LOG_ERROR("plane_id {}: no properties", plane_id_);
+    plane_id_ = 0;
+    return;
+  }
+  const std::pair<std::string_view, uint32_t*> names[] = {
+      {"FB_ID", &props_.fb_id},         {"CRTC_ID", &props_.crtc_id},
+      {"SRC_X", &props_.src_x},         {"SRC_Y", &props_.src_y},
+      {"SRC_W", &props_.src_w},         {"SRC_H", &props_.src_h},
+      {"CRTC_X", &props_.crtc_x},       {"CRTC_Y", &props_.crtc_y},
+      {"CRTC_W", &props_.crtc_w},       {"CRTC_H", &props_.crtc_h},
+      {"HOTSPOT_X", &props_.hotspot_x}, {"HOTSPOT_Y", &props_.hotspot_y},
+  };
+  for (uint32_t p = 0; p < props->count_props; p++) {
+    const auto prop = drm->ModeGetProperty(drm_fd_, props->props[p]);
+    if (!prop) {
+      continue;
+    }
+    for (const auto& [name, id] : names) {
+      if (name == prop->name) {
+        *id = prop->prop_id;
+      }
+    }
+    drm->ModeFreeProperty(prop);
+  }
+  drm->ModeFreeObjectProperties(props);
+
+  // both or neither
+  if (!props_.hotspot_x || !props_.hotspot_y) {
+    props_.hotspot_x = props_.hotspot_y = 0;
+  }
+}
+
+std::list<CursorPlane::Buffer>::iterator CursorPlane::Find(
+    const std::shared_ptr<drmpp::XCursor::Images>& images,
+    const size_t frame) {
+  return std::find_if(pool_.begin(), pool_.end(), [&](const Buffer& buffer) {
+    return buffer.images == images && buffer.frame == frame;
+  });
+}
+
+void CursorPlane::DestroyBuffer(Buffer& buffer) const {
+  drm->ModeRmFB(drm_fd_, buffer.fb.id);
+  drm_mode_destroy_dumb destroy = {.handle = buffer.fb.handle};
+  drm->Ioctl(drm_fd_, DRM_IOCTL_MODE_DESTROY_DUMB, &destroy);
+}
+
+bool CursorPlane::Upload(const std::shared_ptr<drmpp::XCursor::Images>& images,
+                         const size_t frame) {
+  if (!images || frame >= images->images.size() || !images->images[frame]) {
+    return false;
+  }
+  if (const auto it = Find(images, frame); it != pool_.end()) {
+    pool_.splice(pool_.begin(), pool_, it);
+    return true;
+  }
+
+  const auto& image = *images->images[frame];
+  // images larger than the plane are cropped, keep the hotspot inside
+  const auto width = std::min(image.width, width_);
+  const auto height = std::min(image.height, height_);
+  Buffer buffer{
+      .images = images,
+      .frame = frame,
+      .xhot = static_cast<int32_t>(std::min(image.xhot, width - 1)),
+      .yhot = static_cast<int32_t>(std::min(image.yhot, height - 1)),
+      .fb = {.format = DRM_FORMAT_ARGB8888},
+  };
+  if (!drmpp::plane::Common::dumb_fb_init(&buffer.fb, drm_fd_,
+                                          DRM_FORMAT_ARGB8888, width_,
+                                          height_)) {
+    LOG_ERROR("crtc_id {}: failed to create cursor buffer: {}", crtc_id_,
+              strerror(errno));
+    return false;
+  }
+  const auto data = static_cast<uint8_t*>(
+      drmpp::plane::Common::dumb_fb_map(&buffer.fb, drm_fd_));
+  if (data == MAP_FAILED) {
+    LOG_ERROR("crtc_id {}: failed to map cursor buffer", crtc_id_);
+    DestroyBuffer(buffer);
+    return false;
+  }
+
+  // XCursor pixels are premultiplied ARGB, as the plane expects
+  memset(data, 0, buffer.fb.size);
+  for (uint32_t y = 0; y < height; y++) {
+    memcpy(data + y * buffer.fb.stride, &image.pixels[y * image.width],
+           width * sizeof(uint32_t));
+  }
+  munmap(data, buffer.fb.size);
+
+  pool_.push_front(std::move(buffer));
+  Trim();
+  return true;
+}
+
+void CursorPlane::SetPoolCapacity(const size_t capacity) {
+  pool_capacity_ = std::max(capacity, kPoolCapacity);
+  Trim();
+}
+
+void CursorPlane::Trim() {
+  // the current and shown buffers are never evicted
+  auto victim = pool_.end();
+  while (pool_.size() > pool_capacity_ && victim != pool_.begin()) {
+    --victim;
+    if (&*victim == current_ || &*victim == shown_) {
+      continue;
+    }
+    DestroyBuffer(*victim);
+    victim = pool_.erase(victim);
+  }
+}
+
+bool CursorPlane::SetCursor(
+    const std::shared_ptr<drmpp::XCursor::Images>& images,
+    const size_t frame) {
+  if (!Upload(images, frame)) {
+    return false;
+  }
+  current_ = &pool_.front();
+  visible_ = true;
+  return Commit();
+}
+
+bool CursorPlane::Move(const int32_t x,
+                       const int32_t y,
+                       const uint64_t input_time_usec) {
+  x_ = x;
+  y_ = y;
+  input_usec_ = std::max(input_usec_, input_time_usec);
+  if (!visible_) {
+    return true;
+  }
+  // the legacy ioctl is the kernel's cursor fast path: it neither waits for
+  // vblank nor fails while a frame commit is in flight
+  if (IsAtomic() && legacy_move_ && !latency_output_ && shown_ &&
+      shown_ == current_) {
+    if (drm->ModeMoveCursor(drm_fd_, crtc_id_, x_ - current_->xhot,
+                            y_ - current_->yhot) == 0) {
+      shown_x_ = x_ - current_->xhot;
+      shown_y_ = y_ - current_->yhot;
+      return true;
+    }
+    LOG_DEBUG("crtc_id {}: no legacy cursor, moving through atomic", crtc_id_);
+    legacy_move_ = false;
+  }
+  return Commit();
+}
+
+bool CursorPlane::Hide() {
+  visible_ = false;
+  return Commit();
+}
+
+void CursorPlane::AddToRequest(drmModeAtomicReqPtr req) {
+  if (!IsAtomic()) {
+    return;
+  }
+  AddProperties(req);
+  frame_pending_ = true;
+}
+
+bool CursorPlane::OnPageFlip() {
+  frame_pending_ = false;
+  if (!dirty_) {
+    return true;
+  }
+  return Commit();
+}
+
+bool CursorPlane::OnCursorFlip(const unsigned int sec,
+                               const unsigned int usec) {
+  cursor_pending_ = false;
+  if (latency_output_) {
+    latency_output_->OnPageFlip(sec, usec);
+  }
+  if (!dirty_) {
+    return true;
+  }
+  return Commit();
+}
+
+void CursorPlane::SetLatencyOutput(Output* output) {
+  latency_output_ = output;
+}
+
+void CursorPlane::AddProperties(drmModeAtomicReqPtr req) {
+  const auto add = [&](const uint32_t prop, const uint64_t value) {
+    drm->ModeAtomicAddProperty(req, plane_id_, prop, value);
+  };
+  dirty_ = false;
+  if (!visible_ || !current_) {
+    if (shown_) {
+      add(props_.fb_id, 0);
+      add(props_.crtc_id, 0);
+      shown_ = nullptr;
+    }
+    return;
+  }
+
+  // only what changed since the last commit: a move sets the position, an
+  // animation frame the FB_ID
+  const int32_t x = x_ - current_->xhot;
+  const int32_t y = y_ - current_->yhot;
+  if (!shown_) {
+    add(props_.crtc_id, crtc_id_);
+    add(props_.src_x, 0);
+    add(props_.src_y, 0);
+    add(props_.src_w, static_cast<uint64_t>(width_) << 16);
+    add(props_.src_h, static_cast<uint64_t>(height_) << 16);
+    add(props_.crtc_w, width_);
+    add(props_.crtc_h, height_);
+  }
+  if (shown_ != current_) {
+    add(props_.fb_id, current_->fb.id);
+    if (HasHotspot() && (!shown_ || shown_->xhot != current_->xhot ||
+                         shown_->yhot != current_->yhot)) {
+      add(props_.hotspot_x, current_->xhot);
+      add(props_.hotspot_y, current_->yhot);
+    }
+  }
+  if (!shown_ || x != shown_x_ || y != shown_y_) {
+    // signed range properties
+    add(props_.crtc_x, static_cast<uint64_t>(static_cast<int64_t>(x)));
+    add(props_.crtc_y, static_cast<uint64_t>(static_cast<int64_t>(y)));
+  }
+  shown_ = current_;
+  shown_x_ = x;
+  shown_y_ = y;
+}
+
+bool CursorPlane::Commit(const bool blocking) {
+  if (!IsAtomic()) {
+    int ret = 0;
+    if (!visible_ || !current_) {
+      ret = drm->ModeSetCursor2(drm_fd_, crtc_id_, 0, 0, 0, 0, 0);
+      shown_ = nullptr;
+    } else {
+      const bool moved = !shown_ || x_ - current_->xhot != shown_x_ ||
+                         y_ - current_->yhot != shown_y_;
+      if (shown_ != current_) {
+        ret = drm->ModeSetCursor2(drm_fd_, crtc_id_, current_->fb.handle,
+                                  width_, height_, current_->xhot,
+                                  current_->yhot);
+        shown_ = ret == 0 ? current_ : nullptr;
+      }
+      if (ret == 0 && moved) {
+        shown_x_ = x_ - current_->xhot;
+        shown_y_ = y_ - current_->yhot;
+        ret = drm->ModeMoveCursor(drm_fd_, crtc_id_, shown_x_, shown_y_);
+      }
+    }
+    if (ret != 0) {
+      LOG_ERROR("crtc_id {}: failed to set cursor: {}", crtc_id_,
+                strerror(errno));
+      return false;
+    }
+    return true;
+  }
+
+  // a frame or cursor commit in flight would fail this one with EBUSY, go
+  // out from its flip event instead
+  if (!blocking && (frame_pending_ || cursor_pending_)) {
+    dirty_ = true;
+    return true;
+  }
+
+  const auto req = drm->ModeAtomicAlloc();
+  if (!req) {
+    return false;
+  }
+  const auto shown = shown_;
+  const auto shown_x = shown_x_;
+  const auto shown_y = shown_y_;
+  AddProperties(req);
+  const bool empty = drm->ModeAtomicGetCursor(req) == 0;
+  const uint32_t flags =
+      blocking ? 0 : DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT;
+  const bool measured = latency_output_ && !empty && !blocking;
+  if (measured) {
+    latency_output_->SubmitFrame(input_usec_);
+  }
+  const auto ret =
+      empty ? 0
+            : drm->ModeAtomicCommit(drm_fd_, req, flags,
+                                    blocking ? nullptr : this);
+  drm->ModeAtomicFree(req);
+  if (ret == 0 && !empty && !blocking) {
+    cursor_pending_ = true;
+  }
+  if (ret != 0) {
+    if (measured) {
+      latency_output_->CancelFrame();
+    }
+    shown_ = shown;
+    shown_x_ = shown_x;
+    shown_y_ = shown_y;
+    if (errno == EBUSY) {
+      // a frame committed without AddToRequest is in flight, retried from
+      // its OnPageFlip
+      dirty_ = true;
+      return true;
+    }
+    LOG_ERROR("crtc_id {}: cursor commit failed: {}", crtc_id_,
+              strerror(errno));
+    return false;
+  }
+  return true;
+}
@@ -96,3 +96,75 @@ std::unique_ptr<Output> Output::Create(
 
   return output;
 }
+
+void Output::SubmitFrame(const uint64_t input_time_usec) {
+  if (pending_input_usec_.size() >= kMaxPendingFrames) {
+    // OnPageFlip was not called for these, the queue no longer matches flips
+    LOG_WARN("crtc_id {}: {} frames without page flip, dropping them",
+             crtc_id_, pending_input_usec_.size());
+    pending_input_usec_.clear();
+  }
+  // only the first frame to show an input event measures its latency
+  if (input_time_usec != 0 && input_time_usec > last_input_usec_) {
+    last_input_usec_ = input_time_usec;
+    pending_input_usec_.push_back(input_time_usec);
+  } else {
+    pending_input_usec_.push_back(0);
+  }
+}
+
+void Output::CancelFrame() {
+  if (pending_input_usec_.empty()) {
+    return;
+  }
+  if (const auto input_usec = pending_input_usec_.back(); input_usec != 0) {
+    last_input_usec_ = input_usec - 1;
+  }
+  pending_input_usec_.pop_back();
+}
+
+void Output::OnPageFlip(const unsigned int sec, const unsigned int usec) {
+  const auto flip_usec = static_cast<uint64_t>(sec) * 1000000 + usec;
+  last_flip_usec_ = flip_usec;
+  if (pending_input_usec_.empty()) {
+    return;
+  }
+  const auto input_usec = pending_input_usec_.front();
+  pending_input_usec_.pop_front();
+  if (input_usec == 0) {
+    return;
+  }
+  if (flip_usec < input_usec) {
+    LOG_WARN("crtc_id {}: page flip precedes input, non-monotonic timestamps?",
+             crtc_id_);
+    return;
+  }
+  latency_.add(flip_usec - input_usec);
+}
+
+uint64_t Output::EstimateNextVblank(const uint64_t now_usec) const {
+  if (last_flip_usec_ == 0 || refresh_ == 0) {
+    return now_usec;
+  }
+  // refresh_ is in mHz
+  const uint64_t period_usec = 1000000000ULL / refresh_;
+  if (now_usec <= last_flip_usec_) {
+    return last_flip_usec_;
+  }
+  const auto periods = (now_usec - last_flip_usec_ + period_usec - 1) /
+                       period_usec;
+  return last_flip_usec_ + periods * period_usec;
+}
+
+void Output::ResetLatency() {
+  latency_.reset();
+}
+
+void Output::LogLatency() const {
+  LOG_INFO(
+      "crtc_id {}: input-to-scanout latency usec: count {}, min {}, p50 {}, "
+      "p90 {}, p99 {}, max {}, mean {}",
+      crtc_id_, latency_.count(), latency_.min(), latency_.percentile(50),
+      latency_.percentile(90), latency_.percentile(99), latency_.max(),
+      latency_.mean());
+}
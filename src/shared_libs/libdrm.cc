@@ -71,6 +71,9 @@ LibDrmExports::LibDrmExports(void* lib) {
     GetFuncAddress(lib, "drmModeGetPlane", &ModeGetPlane);
     GetFuncAddress(lib, "drmModeFreePlane", &ModeFreePlane);
     GetFuncAddress(lib, "drmModeRmFB", &ModeRmFB);
+    GetFuncAddress(lib, "drmModeSetCursor2", &ModeSetCursor2);
+    GetFuncAddress(lib, "drmModeMoveCursor", &ModeMoveCursor);
+    GetFuncAddress(lib, "drmModePageFlip", &ModePageFlip);
   }
 }
 
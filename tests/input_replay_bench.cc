@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Dispatch throughput of a recorded input trace, replayed on a path seat
+// without devices so the result does not depend on the machine. The trace
+// in tests/data holds one keyboard and pointer device, 500 relative motions
+// and a key and button click every 50 motions.
+
+#include <getopt.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "drmpp/input/event_replayer.h"
+#include "drmpp/input/keymap_cache.h"
+#include "drmpp/input/seat.h"
+
+namespace {
+// Checks the seat state a replay of the whole trace leaves behind.
+bool check_seat(const drmpp::input::Seat& seat,
+                const drmpp::input::EventReplayer& replayer) {
+  uint64_t timestamped = 0;
+  uint64_t last_usec = 0;
+  for (uint64_t i = 0; i < replayer.size(); i++) {
+    if (const auto time_usec = replayer.records()[i].time_usec;
+        time_usec != 0) {
+      timestamped++;
+      last_usec = time_usec;
+    }
+  }
+  const auto token = seat.get_input_token();
+  if (token.sequence != timestamped || token.time_usec != last_usec) {
+    printf("input token %llu@%llu, expected %llu@%llu\n",
+           static_cast<unsigned long long>(token.sequence),
+           static_cast<unsigned long long>(token.time_usec),
+           static_cast<unsigned long long>(timestamped),
+           static_cast<unsigned long long>(last_usec));
+    return false;
+  }
+  const auto keyboards = seat.get_keyboards();
+  if (!keyboards.has_value() || keyboards.value()->size() != 1 ||
+      !seat.get_pointer().has_value()) {
+    printf("replayed devices missing\n");
+    return false;
+  }
+  return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  int iterations = 200;
+
+  const option longopts[] = {{"iterations", required_argument, nullptr, 'n'},
+                             {"help", no_argument, nullptr, 'h'},
+                             {nullptr, 0, nullptr, 0}};
+  int c;
+  while ((c = getopt_long(argc, argv, "n:h", longopts, nullptr)) != -1) {
+    switch (c) {
+      case 'n':
+        iterations = std::max(atoi(optarg), 1);
+        break;
+      default:
+        printf("usage: %s [-n iterations] trace\n", argv[0]);
+        return c == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+  if (optind >= argc) {
+    printf("usage: %s [-n iterations] trace\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  drmpp::input::EventReplayer replayer;
+  if (!replayer.open(argv[optind])) {
+    return EXIT_FAILURE;
+  }
+
+  // the keymap is compiled once and shared by the seat of each iteration
+  const auto keymap_cache = std::make_shared<drmpp::input::KeymapCache>();
+  std::chrono::duration<double> elapsed{};
+  uint64_t total = 0;
+  for (int i = 0; i < iterations; i++) {
+    drmpp::input::Seat seat(keymap_cache, "replay", true);
+    const auto start = std::chrono::steady_clock::now();
+    total += replayer.replay(seat, false);
+    elapsed += std::chrono::steady_clock::now() - start;
+    if (!check_seat(seat, replayer)) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  const auto records = static_cast<double>(std::max<uint64_t>(total, 1));
+  printf("%llu records, %d iterations: %.1f ns/record\n",
+         static_cast<unsigned long long>(replayer.size()), iterations,
+         elapsed.count() * 1e9 / records);
+  return EXIT_SUCCESS;
+}
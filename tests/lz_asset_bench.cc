@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Decompression throughput of the built-in LZ assets, comparing
+// utils::decompress_lz_asset with the byte loop it replaced and with
+// fastlz_decompress.
+
+#include <getopt.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "input/default_cursor.h"
+#include "input/default_xkeymap.h"
+#include "input/fastlz.h"
+#include "utils/utils.h"
+
+namespace {
+// The byte at a time loop decompress_lz_asset used before, as a reference.
+std::vector<uint8_t> reference_decompress(const uint8_t data[],
+                                          const size_t compressed_size,
+                                          const size_t uncompressed_size) {
+  int src = 0;
+  int dest = 0;
+
+  const uint8_t* input = data;
+  const int length = static_cast<int>(compressed_size);
+  std::vector<uint8_t> buffer(uncompressed_size, 0);
+
+  uint8_t* output = buffer.data();
+
+  while (src < length) {
+    if (const int type = input[src] >> 5; type == 0) {
+      // literal run
+      int run = 1 + input[src];
+      src = src + 1;
+      while (run > 0) {
+        output[dest] = input[src];
+        src = src + 1;
+        dest = dest + 1;
+        run = run - 1;
+      }
+    } else if (type < 7) {
+      // short match
+      const int ofs = 256 * (input[src] & 31) + input[src + 1];
+      int len = 2 + (input[src] >> 5);
+      src = src + 2;
+      int ref = dest - ofs - 1;
+      while (len > 0) {
+        output[dest] = output[ref];
+        ref = ref + 1;
+        dest = dest + 1;
+        len = len - 1;
+      }
+    } else {
+      // long match
+      const int ofs = 256 * (input[src] & 31) + input[src + 2];
+      int len = 9 + input[src + 1];
+      src = src + 3;
+      int ref = dest - ofs - 1;
+      while (len > 0) {
+        output[dest] = output[ref];
+        ref = ref + 1;
+        dest = dest + 1;
+        len = len - 1;
+      }
+    }
+  }
+  return buffer;
+}
+
+// The reference loop with bounds checks, for inputs that may be corrupt.
+// Returns an empty vector where decompress_lz_asset must reject the input.
+std::vector<uint8_t> checked_reference_decompress(
+    const uint8_t data[],
+    const size_t compressed_size,
+    const size_t uncompressed_size) {
+  size_t src = 0;
+  std::vector<uint8_t> buffer;
+  buffer.reserve(uncompressed_size);
+
+  while (src < compressed_size) {
+    const int ctrl = data[src++];
+    if (const int type = ctrl >> 5; type == 0) {
+      // literal run
+      for (int run = 1 + ctrl; run > 0; run--) {
+        if (src == compressed_size || buffer.size() == uncompressed_size) {
+          return {};
+        }
+        buffer.push_back(data[src++]);
+      }
+    } else {
+      // short match, or long match with an extra length byte
+      size_t len = 2 + static_cast<size_t>(type);
+      if (type == 7) {
+        if (src == compressed_size) {
+          return {};
+        }
+        len += data[src++];
+      }
+      if (src == compressed_size) {
+        return {};
+      }
+      const size_t ofs = 256 * static_cast<size_t>(ctrl & 31) + data[src++];
+      if (ofs + 1 > buffer.size() ||
+          len > uncompressed_size - buffer.size()) {
+        return {};
+      }
+      for (size_t ref = buffer.size() - ofs - 1; len > 0; len--) {
+        buffer.push_back(buffer[ref++]);
+      }
+    }
+  }
+  if (buffer.size() != uncompressed_size) {
+    return {};
+  }
+  return buffer;
+}
+
+std::vector<uint8_t> fastlz(const uint8_t data[],
+                            const size_t compressed_size,
+                            const size_t uncompressed_size) {
+  std::vector<uint8_t> buffer(uncompressed_size);
+  const int size =
+      fastlz_decompress(data, static_cast<int>(compressed_size), buffer.data(),
+                        static_cast<int>(uncompressed_size));
+  buffer.resize(static_cast<size_t>(size));
+  return buffer;
+}
+
+using Decompress = std::function<
+    std::vector<uint8_t>(const uint8_t[], size_t compressed, size_t size)>;
+
+struct Bench {
+  const char* name;
+  Decompress decompress;
+};
+
+// Returns the decompressed MB/s, or 0 if the output does not match.
+double run(const Bench& bench,
+           const uint8_t data[],
+           const size_t compressed_size,
+           const std::vector<uint8_t>& expected,
+           const int iterations) {
+  if (bench.decompress(data, compressed_size, expected.size()) != expected) {
+    return 0;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  size_t total = 0;
+  for (int i = 0; i < iterations; i++) {
+    total += bench.decompress(data, compressed_size, expected.size()).size();
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return static_cast<double>(total) / elapsed.count() / 1e6;
+}
+
+// Truncated copies of an asset must be rejected, and garbled copies must
+// decode as the checked reference does, without touching memory outside the
+// buffers, which ASan builds catch.
+bool check_corrupt(const uint8_t data[],
+                   const size_t compressed_size,
+                   const size_t uncompressed_size) {
+  const auto step = std::max<size_t>(compressed_size / 64, 1);
+  for (size_t len = 0; len < compressed_size; len += step) {
+    const std::vector<uint8_t> truncated(data, data + len);
+    if (!drmpp::utils::decompress_lz_asset(truncated.data(), len,
+                                           uncompressed_size)
+             .empty()) {
+      return false;
+    }
+  }
+  std::vector<uint8_t> garbled(data, data + compressed_size);
+  srand(1);
+  for (int i = 0; i < 1000; i++) {
+    garbled[static_cast<size_t>(rand()) % garbled.size()] =
+        static_cast<uint8_t>(rand());
+    if (drmpp::utils::decompress_lz_asset(garbled.data(), garbled.size(),
+                                          uncompressed_size) !=
+        checked_reference_decompress(garbled.data(), garbled.size(),
+                                     uncompressed_size)) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  int iterations = 2000;
+
+  const option longopts[] = {{"iterations", required_argument, nullptr, 'n'},
+                             {"help", no_argument, nullptr, 'h'},
+                             {nullptr, 0, nullptr, 0}};
+  int c;
+  while ((c = getopt_long(argc, argv, "n:h", longopts, nullptr)) != -1) {
+    switch (c) {
+      case 'n':
+        iterations = std::max(atoi(optarg), 1);
+        break;
+      default:
+        printf("usage: %s [-n iterations]\n", argv[0]);
+        return c == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  // decompress_lz_asset logs each call, and each corrupt input
+  spdlog::set_level(spdlog::level::off);
+
+  const Bench benches[] = {
+      {"decompress_lz_asset", drmpp::utils::decompress_lz_asset},
+      {"reference", reference_decompress},
+      {"fastlz_decompress", fastlz},
+  };
+
+  struct {
+    const char* name;
+    const uint8_t* data;
+    size_t compressed_size;
+    size_t uncompressed_size;
+  } const assets[] = {
+      {"xkeymap", kDefaultXKeymap.data, kDefaultXKeymap.compressed_size,
+       kDefaultXKeymap.uncompressed_size},
+      {"cursor", kDefaultCursor.data, kDefaultCursor.compressed_size,
+       kDefaultCursor.uncompressed_size},
+  };
+
+  int result = EXIT_SUCCESS;
+  for (const auto& asset : assets) {
+    const auto expected = reference_decompress(
+        asset.data, asset.compressed_size, asset.uncompressed_size);
+    printf("%s: %zu -> %zu bytes, %d iterations\n", asset.name,
+           asset.compressed_size, asset.uncompressed_size, iterations);
+    for (const auto& bench : benches) {
+      const auto mbps = run(bench, asset.data, asset.compressed_size,
+                            expected, iterations);
+      if (mbps == 0) {
+        printf("  %-20s output mismatch\n", bench.name);
+        result = EXIT_FAILURE;
+        continue;
+      }
+      printf("  %-20s %10.1f MB/s\n", bench.name, mbps);
+    }
+    if (!check_corrupt(asset.data, asset.compressed_size,
+                       asset.uncompressed_size)) {
+      printf("  corrupt input not rejected\n");
+      result = EXIT_FAILURE;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit test of utils::ObserverList. The concurrent case is meant to run
+// under ASan or TSan as well.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "utils/observer_list.h"
+
+namespace {
+std::atomic<int> failures{};
+
+#define EXPECT(cond)                                              \
+  do {                                                            \
+    if (!(cond)) {                                                \
+      printf("%s:%d: expected %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                                 \
+    }                                                             \
+  } while (0)
+
+struct Observer {
+  int calls = 0;
+};
+
+using List = drmpp::utils::ObserverList<Observer>;
+
+std::vector<Observer*> collect(const List& list) {
+  std::vector<Observer*> result;
+  list.for_each([&](Observer* observer) { result.push_back(observer); });
+  return result;
+}
+
+void test_add_remove() {
+  List list;
+  Observer a, b;
+  EXPECT(list.empty());
+  EXPECT(collect(list).empty());
+
+  list.add(&a);
+  list.add(&b);
+  list.add(&a);
+  EXPECT(!list.empty());
+  EXPECT(collect(list) == (std::vector<Observer*>{&a, &b}));
+
+  list.remove(&a);
+  EXPECT(collect(list) == std::vector<Observer*>{&b});
+  list.remove(&a);
+  list.remove(&b);
+  EXPECT(list.empty());
+}
+
+// A callback sees the observers registered when the dispatch started.
+void test_modify_in_callback() {
+  List list;
+  Observer a, b;
+  list.add(&a);
+  list.for_each([&](Observer* observer) {
+    observer->calls++;
+    list.remove(&a);
+    list.add(&b);
+  });
+  EXPECT(a.calls == 1);
+  EXPECT(b.calls == 0);
+  EXPECT(collect(list) == std::vector<Observer*>{&b});
+
+  // nested dispatches, the retired arrays are freed by the outer one
+  list.for_each([&](Observer*) {
+    list.add(&a);
+    list.for_each([&](Observer* observer) { observer->calls++; });
+    list.remove(&a);
+  });
+  EXPECT(a.calls == 2);
+  EXPECT(b.calls == 1);
+  EXPECT(collect(list) == std::vector<Observer*>{&b});
+}
+
+void test_concurrent() {
+  List list;
+  Observer a, b;
+  list.add(&a);
+  std::atomic<bool> done{};
+  std::atomic<int> dispatched{};
+  std::thread reader([&] {
+    while (!done.load()) {
+      list.for_each([&](Observer* observer) {
+        EXPECT(observer == &a || observer == &b);
+        dispatched.fetch_add(1, std::memory_order_relaxed);
+      });
+    }
+  });
+  for (int i = 0; i < 100000; i++) {
+    list.add(&b);
+    list.remove(&b);
+  }
+  done = true;
+  reader.join();
+  EXPECT(collect(list) == std::vector<Observer*>{&a});
+  EXPECT(dispatched.load() > 0);
+}
+}  // namespace
+
+int main() {
+  test_add_remove();
+  test_modify_in_callback();
+  test_concurrent();
+  if (failures) {
+    printf("%d failures\n", failures.load());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2024 The drmpp Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit test of utils::SpscRing. The threaded case is meant to run under
+// TSan as well.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "utils/spsc_ring.h"
+
+namespace {
+std::atomic<int> failures{};
+
+#define EXPECT(cond)                                              \
+  do {                                                            \
+    if (!(cond)) {                                                \
+      printf("%s:%d: expected %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                                 \
+    }                                                             \
+  } while (0)
+
+void test_full_and_empty() {
+  drmpp::utils::SpscRing<uint32_t, 8> ring;
+  uint32_t value = 0;
+  EXPECT(ring.capacity() == 8);
+  EXPECT(ring.size() == 0);
+  EXPECT(!ring.pop(value));
+
+  for (uint32_t i = 0; i < 8; i++) {
+    EXPECT(ring.push(i));
+  }
+  EXPECT(ring.size() == 8);
+  EXPECT(!ring.push(8));
+
+  for (uint32_t i = 0; i < 8; i++) {
+    EXPECT(ring.pop(value));
+    EXPECT(value == i);
+  }
+  EXPECT(ring.size() == 0);
+  EXPECT(!ring.pop(value));
+}
+
+// Indices keep counting past the capacity, slots are reused in order.
+void test_wrap() {
+  drmpp::utils::SpscRing<uint32_t, 4> ring;
+  uint32_t value = 0;
+  for (uint32_t i = 0; i < 100; i++) {
+    EXPECT(ring.push(2 * i));
+    EXPECT(ring.push(2 * i + 1));
+    EXPECT(ring.size() == 2);
+    EXPECT(ring.pop(value));
+    EXPECT(value == 2 * i);
+    EXPECT(ring.pop(value));
+    EXPECT(value == 2 * i + 1);
+  }
+}
+
+void test_threaded() {
+  static constexpr uint64_t kCount = 1000000;
+  drmpp::utils::SpscRing<uint64_t, 256> ring;
+  std::thread producer([&] {
+    for (uint64_t i = 0; i < kCount;) {
+      if (ring.push(i)) {
+        i++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint64_t expected = 0;
+  uint64_t value = 0;
+  while (expected < kCount) {
+    if (!ring.pop(value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    // keep draining on a mismatch, the producer would block otherwise
+    EXPECT(value == expected);
+    expected = value + 1;
+  }
+  producer.join();
+}
+}  // namespace
+
+int main() {
+  test_full_and_empty();
+  test_wrap();
+  test_threaded();
+  if (failures) {
+    printf("%d failures\n", failures.load());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}